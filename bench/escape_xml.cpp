@@ -0,0 +1,119 @@
+// Compares `vrdi::escape_xml` against the previous byte-at-a-time version.
+
+#include <vrdi/escape.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+    [[nodiscard]] std::string escape_xml_reference(const std::string& x)
+    {
+        std::string s;
+        s.reserve(x.size() * 1.4f);
+
+        for(std::size_t i = 0; i != x.size(); ++i)
+        {
+            switch(x[i])
+            {
+                case '&': s.append("&amp;"); break;
+                case '\"': s.append("&quot;"); break;
+                case '\'': s.append("&apos;"); break;
+                case '<': s.append("&lt;"); break;
+                case '>': s.append("&gt;"); break;
+                case '`': break;
+                default: s.append(&x[i], 1); break;
+            }
+        }
+
+        return s;
+    }
+
+    // Random printable text where roughly one byte in `special_every` needs
+    // escaping.
+    [[nodiscard]] std::vector<std::string> make_inputs(
+        std::size_t count, std::size_t length, unsigned int special_every)
+    {
+        std::mt19937 rng{1234};
+        std::uniform_int_distribution<int> printable{' ', '~'};
+        std::uniform_int_distribution<unsigned int> pick{0, special_every - 1};
+
+        const std::string specials{"&\"'<>`"};
+
+        std::vector<std::string> result(count);
+        for(std::string& s : result)
+        {
+            s.resize(length);
+            for(char& c : s)
+            {
+                do
+                {
+                    c = static_cast<char>(printable(rng));
+                } while(specials.find(c) != std::string::npos);
+
+                if(pick(rng) == 0)
+                {
+                    c = specials[rng() % specials.size()];
+                }
+            }
+        }
+
+        return result;
+    }
+
+    template <typename TF>
+    [[nodiscard]] double measure_ms(
+        const std::vector<std::string>& inputs, std::size_t& sink, TF&& f)
+    {
+        const auto start = std::chrono::steady_clock::now();
+
+        for(int rep = 0; rep < 5; ++rep)
+        {
+            for(const std::string& s : inputs)
+            {
+                sink += f(s).size();
+            }
+        }
+
+        return std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start)
+            .count();
+    }
+} // namespace
+
+int main()
+{
+    std::size_t sink = 0;
+
+    for(const auto& [length, special_every] :
+        {std::pair{64u, 200u}, std::pair{64u, 8u}, std::pair{4096u, 200u},
+            std::pair{4096u, 8u}})
+    {
+        // About 8MB of input per configuration.
+        const std::vector<std::string> inputs =
+            make_inputs(8'000'000 / length, length, special_every);
+
+        for(const std::string& s : inputs)
+        {
+            if(vrdi::escape_xml(s) != escape_xml_reference(s))
+            {
+                std::printf("mismatch for input '%s'\n", s.c_str());
+                return 1;
+            }
+        }
+
+        const double old_ms = measure_ms(inputs, sink, escape_xml_reference);
+        const double new_ms = measure_ms(inputs, sink,
+            [](const std::string& s) { return vrdi::escape_xml(s); });
+
+        std::printf("length %5u, 1/%3u special: old %8.2fms, new %8.2fms "
+                    "(%.2fx)\n",
+            length, special_every, old_ms, new_ms, old_ms / new_ms);
+    }
+
+    return sink == 0;
+}
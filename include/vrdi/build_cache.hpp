@@ -0,0 +1,187 @@
+#pragma once
+
+#include "./hash.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+
+namespace vrdi
+{
+    // Persistent on-disk cache used for incremental builds:
+    //
+    // * Rendered Markdown fragments, stored as `fragments/<key>.html`, where
+    //   `<key>` is a hash of the source bytes and of the renderer version.
+    //
+    // * A manifest mapping every page to the hash of all the inputs it was
+    //   last generated from. Pages whose inputs did not change are neither
+    //   re-rendered nor rewritten.
+    class build_cache
+    {
+    private:
+        std::filesystem::path _root;
+        bool _enabled;
+
+        mutable std::mutex _mtx;
+        std::unordered_map<std::string, std::uint64_t> _old_page_keys;
+        std::unordered_map<std::string, std::uint64_t> _new_page_keys;
+
+        std::atomic<std::uint64_t> _next_temp_id{0};
+
+        [[nodiscard]] std::filesystem::path manifest_path() const
+        {
+            return _root / "manifest";
+        }
+
+        [[nodiscard]] std::filesystem::path fragment_path(
+            std::uint64_t key) const
+        {
+            return _root / "fragments" / (to_hex(key) + ".html");
+        }
+
+        void load_manifest()
+        {
+            std::ifstream ifs{manifest_path()};
+
+            std::string line;
+            while(std::getline(ifs, line))
+            {
+                // Lines of a damaged manifest are skipped, and their pages
+                // rebuilt.
+                const auto tab = line.find('\t');
+                if(tab == std::string::npos)
+                {
+                    continue;
+                }
+
+                const std::optional<std::uint64_t> key =
+                    parse_hex(std::string_view{line}.substr(0, tab));
+
+                if(key)
+                {
+                    _old_page_keys[line.substr(tab + 1)] = *key;
+                }
+            }
+        }
+
+    public:
+        explicit build_cache(std::filesystem::path root, bool enabled)
+            : _root{std::move(root)}, _enabled{enabled}
+        {
+            if(!_enabled)
+            {
+                return;
+            }
+
+            std::filesystem::create_directories(_root / "fragments");
+            load_manifest();
+        }
+
+        [[nodiscard]] bool enabled() const noexcept
+        {
+            return _enabled;
+        }
+
+        [[nodiscard]] std::optional<std::string> load_fragment(
+            std::uint64_t key) const
+        {
+            if(!_enabled)
+            {
+                return std::nullopt;
+            }
+
+            const std::filesystem::path p = fragment_path(key);
+
+            std::error_code ec;
+            if(!std::filesystem::is_regular_file(p, ec))
+            {
+                return std::nullopt;
+            }
+
+            return read_file(p);
+        }
+
+        void store_fragment(std::uint64_t key, const std::string& html)
+        {
+            if(!_enabled)
+            {
+                return;
+            }
+
+            // Write to an unique temporary file and rename it into place, so
+            // that concurrent readers never observe a partial fragment.
+            const std::filesystem::path p = fragment_path(key);
+            std::filesystem::path temp = p;
+            temp += ".tmp" + std::to_string(_next_temp_id++);
+
+            {
+                std::ofstream o{temp, std::ios::binary};
+                o << html;
+            }
+
+            std::error_code ec;
+            std::filesystem::rename(temp, p, ec);
+        }
+
+        // Returns `true` if the page named `name` was last generated from
+        // inputs with the same `key`.
+        [[nodiscard]] bool is_page_fresh(
+            const std::string& name, std::uint64_t key) const
+        {
+            if(!_enabled)
+            {
+                return false;
+            }
+
+            std::scoped_lock lock{_mtx};
+
+            const auto it = _old_page_keys.find(name);
+            return it != _old_page_keys.end() && it->second == key;
+        }
+
+        void record_page(const std::string& name, std::uint64_t key)
+        {
+            std::scoped_lock lock{_mtx};
+            _new_page_keys[name] = key;
+        }
+
+        void save_manifest() const
+        {
+            if(!_enabled)
+            {
+                return;
+            }
+
+            std::scoped_lock lock{_mtx};
+
+            std::ostringstream oss;
+            for(const auto& [name, key] : _new_page_keys)
+            {
+                oss << to_hex(key) << '\t' << name << '\n';
+            }
+
+            write_file_atomically(manifest_path(), oss.str());
+        }
+
+        // Makes the keys recorded so far the reference for `is_page_fresh`,
+        // for processes performing several builds (e.g. watch mode).
+        void commit()
+        {
+            std::scoped_lock lock{_mtx};
+
+            for(const auto& [name, key] : _new_page_keys)
+            {
+                _old_page_keys[name] = key;
+            }
+        }
+    };
+} // namespace vrdi
@@ -0,0 +1,469 @@
+#pragma once
+
+#include "./hash.hpp"
+#include "./thread_pool.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include <zlib.h>
+
+#ifdef VRDI_HAS_BROTLI
+#include <brotli/encode.h>
+#endif
+
+#ifdef VRDI_HAS_ZSTD
+#include <zstd.h>
+#endif
+
+namespace vrdi
+{
+    [[nodiscard]] inline std::optional<std::string> compress_gzip(
+        std::string_view x)
+    {
+        z_stream zs{};
+
+        // `15 + 16`: maximum window, with a gzip header and trailer.
+        if(deflateInit2(&zs, Z_BEST_COMPRESSION, Z_DEFLATED, 15 + 16, 9,
+               Z_DEFAULT_STRATEGY) != Z_OK)
+        {
+            return std::nullopt;
+        }
+
+        std::string result;
+        result.resize(deflateBound(&zs, static_cast<uLong>(x.size())));
+
+        zs.next_in =
+            reinterpret_cast<Bytef*>(const_cast<char*>(x.data())); // NOLINT
+        zs.avail_in = static_cast<uInt>(x.size());
+        zs.next_out = reinterpret_cast<Bytef*>(result.data());
+        zs.avail_out = static_cast<uInt>(result.size());
+
+        const int rc = deflate(&zs, Z_FINISH);
+        result.resize(zs.total_out);
+        deflateEnd(&zs);
+
+        if(rc != Z_STREAM_END)
+        {
+            return std::nullopt;
+        }
+
+        return result;
+    }
+
+#ifdef VRDI_HAS_BROTLI
+    [[nodiscard]] inline std::optional<std::string> compress_brotli(
+        std::string_view x)
+    {
+        std::string result;
+        result.resize(BrotliEncoderMaxCompressedSize(x.size()));
+
+        std::size_t size = result.size();
+        if(!BrotliEncoderCompress(BROTLI_MAX_QUALITY, BROTLI_MAX_WINDOW_BITS,
+               BROTLI_MODE_TEXT, x.size(),
+               reinterpret_cast<const std::uint8_t*>(x.data()), &size,
+               reinterpret_cast<std::uint8_t*>(result.data())))
+        {
+            return std::nullopt;
+        }
+
+        result.resize(size);
+        return result;
+    }
+#endif
+
+#ifdef VRDI_HAS_ZSTD
+    [[nodiscard]] inline std::optional<std::string> compress_zstd(
+        std::string_view x)
+    {
+        std::string result;
+        result.resize(ZSTD_compressBound(x.size()));
+
+        const std::size_t size = ZSTD_compress(result.data(), result.size(),
+            x.data(), x.size(), ZSTD_maxCLevel());
+
+        if(ZSTD_isError(size))
+        {
+            return std::nullopt;
+        }
+
+        result.resize(size);
+        return result;
+    }
+#endif
+
+    // Writes precompressed sidecars (`.gz`, plus `.br` and `.zst` when the
+    // libraries are available) next to every text file in a tree, so that
+    // a web server can serve them without compressing per request.
+    //
+    // * Files are compressed in parallel, one pool task per file.
+    // * Sidecars whose file no longer exists are removed.
+    // * The size, modification time and content hash of every compressed
+    //   file are remembered in an index. Files whose size and time did not
+    //   change are skipped without being read; files whose contents hash to
+    //   the recorded value are skipped without being compressed.
+    class sidecar_compressor
+    {
+    public:
+        // Called from any thread with the path of every sidecar written.
+        using written_fn = std::function<void(const std::filesystem::path&)>;
+
+    private:
+        struct record
+        {
+            std::uint64_t _size;
+            std::int64_t _mtime;
+            std::uint64_t _hash;
+        };
+
+        using compress_fn = std::optional<std::string> (*)(std::string_view);
+
+        struct format
+        {
+            std::string_view _extension;
+            compress_fn _compress;
+        };
+
+        thread_pool& _pool;
+        std::filesystem::path _index_path;
+
+        std::mutex _index_mtx;
+        std::unordered_map<std::string, record> _records;
+
+        std::atomic<std::size_t> _compressed_count{0};
+
+        [[nodiscard]] static const std::vector<format>& formats()
+        {
+            static const std::vector<format> result{
+                {".gz", &compress_gzip},
+#ifdef VRDI_HAS_BROTLI
+                {".br", &compress_brotli},
+#endif
+#ifdef VRDI_HAS_ZSTD
+                {".zst", &compress_zstd},
+#endif
+            };
+
+            return result;
+        }
+
+        [[nodiscard]] static bool is_text_file(const std::filesystem::path& p)
+        {
+            static const std::unordered_set<std::string> extensions{".html",
+                ".rss", ".atom", ".xml", ".css", ".js", ".json", ".svg",
+                ".txt"};
+
+            return extensions.count(p.extension().string()) > 0;
+        }
+
+        // If `p` is a sidecar, the path of the file it belongs to.
+        [[nodiscard]] static std::optional<std::filesystem::path>
+        sidecar_source(const std::filesystem::path& p)
+        {
+            const std::string extension = p.extension().string();
+
+            for(const format& f : formats())
+            {
+                if(extension == f._extension)
+                {
+                    std::filesystem::path source = p;
+                    source.replace_extension();
+
+                    if(is_text_file(source))
+                    {
+                        return source;
+                    }
+                }
+            }
+
+            return std::nullopt;
+        }
+
+        [[nodiscard]] static std::filesystem::path sidecar_path(
+            const std::filesystem::path& p, std::string_view extension)
+        {
+            std::filesystem::path result = p;
+            result += std::string{extension};
+
+            return result;
+        }
+
+        [[nodiscard]] static bool has_all_sidecars(
+            const std::filesystem::path& p)
+        {
+            std::error_code ec;
+
+            for(const format& f : formats())
+            {
+                if(!std::filesystem::exists(sidecar_path(p, f._extension), ec))
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        [[nodiscard]] static std::int64_t mtime_of(
+            const std::filesystem::path& p, std::error_code& ec)
+        {
+            const auto t = std::filesystem::last_write_time(p, ec);
+            return static_cast<std::int64_t>(t.time_since_epoch().count());
+        }
+
+        void load_index()
+        {
+            std::ifstream ifs{_index_path};
+
+            std::string line;
+            while(std::getline(ifs, line))
+            {
+                std::istringstream iss{line};
+
+                std::string hash;
+                record r{};
+
+                if(!(iss >> hash >> r._size >> r._mtime) || iss.get() != '\t')
+                {
+                    continue;
+                }
+
+                // Files with a damaged record are compressed again.
+                const std::optional<std::uint64_t> parsed = parse_hex(hash);
+                if(!parsed)
+                {
+                    continue;
+                }
+
+                std::string path;
+                std::getline(iss, path);
+
+                r._hash = *parsed;
+                _records[path] = r;
+            }
+        }
+
+        [[nodiscard]] std::optional<record> find_record(const std::string& key)
+        {
+            std::scoped_lock lock{_index_mtx};
+
+            const auto it = _records.find(key);
+            if(it == _records.end())
+            {
+                return std::nullopt;
+            }
+
+            return it->second;
+        }
+
+        void compress_file(
+            const std::filesystem::path& p, const written_fn& on_written)
+        {
+            namespace fs = std::filesystem;
+
+            std::error_code ec;
+            const std::uint64_t size = fs::file_size(p, ec);
+            const std::int64_t mtime = mtime_of(p, ec);
+
+            if(ec)
+            {
+                return;
+            }
+
+            const std::string key = p.string();
+            const std::optional<record> old = find_record(key);
+            const bool sidecars_exist = has_all_sidecars(p);
+
+            if(old && sidecars_exist && old->_size == size &&
+                old->_mtime == mtime)
+            {
+                return;
+            }
+
+            const std::string contents = read_file(p);
+            const std::uint64_t hash = hash_bytes(contents);
+
+            if(old && sidecars_exist && old->_hash == hash)
+            {
+                // Same contents, rewritten: keep the sidecars, but make sure
+                // they do not look older than the file they belong to.
+                for(const format& f : formats())
+                {
+                    fs::last_write_time(sidecar_path(p, f._extension),
+                        fs::last_write_time(p, ec), ec);
+                }
+            }
+            else
+            {
+                for(const format& f : formats())
+                {
+                    const std::optional<std::string> compressed =
+                        f._compress(contents);
+
+                    if(!compressed)
+                    {
+                        continue;
+                    }
+
+                    const fs::path target = sidecar_path(p, f._extension);
+
+                    fs::path temp = target;
+                    temp += ".tmp";
+
+                    bool written;
+
+                    {
+                        std::ofstream o{
+                            temp, std::ios::binary | std::ios::trunc};
+                        o.write(compressed->data(),
+                            static_cast<std::streamsize>(compressed->size()));
+
+                        o.close();
+                        written = static_cast<bool>(o);
+                    }
+
+                    std::error_code rename_ec;
+                    if(written)
+                    {
+                        fs::rename(temp, target, rename_ec);
+                    }
+
+                    if(!written || rename_ec)
+                    {
+                        fs::remove(temp, rename_ec);
+                        return;
+                    }
+
+                    if(on_written)
+                    {
+                        on_written(target);
+                    }
+                }
+
+                ++_compressed_count;
+            }
+
+            std::scoped_lock lock{_index_mtx};
+            _records[key] = record{size, mtime, hash};
+        }
+
+    public:
+        // If `index_path` is not empty, records are loaded from and saved to
+        // it.
+        explicit sidecar_compressor(
+            thread_pool& pool, std::filesystem::path index_path = {})
+            : _pool{pool}, _index_path{std::move(index_path)}
+        {
+            if(!_index_path.empty())
+            {
+                load_index();
+            }
+        }
+
+        // Compresses every changed text file under each of `roots` and
+        // removes orphaned sidecars. Directory symlinks are not followed, so
+        // a linked tree that needs sidecars must be passed as a root of its
+        // own. Returns the number of files compressed.
+        std::size_t compress_trees(
+            const std::vector<std::filesystem::path>& roots,
+            const written_fn& on_written = {})
+        {
+            namespace fs = std::filesystem;
+
+            _compressed_count = 0;
+
+            std::vector<fs::path> files;
+            std::unordered_set<std::string> live;
+
+            std::error_code ec;
+            for(const fs::path& root : roots)
+            {
+                for(fs::recursive_directory_iterator it{root, ec}, end;
+                    it != end; it.increment(ec))
+                {
+                    if(!it->is_regular_file(ec))
+                    {
+                        continue;
+                    }
+
+                    const fs::path& p = it->path();
+
+                    if(is_text_file(p))
+                    {
+                        files.emplace_back(p);
+                        live.emplace(p.string());
+                    }
+                    else if(const auto source = sidecar_source(p);
+                            source && !fs::exists(*source, ec))
+                    {
+                        fs::remove(p, ec);
+                    }
+                }
+            }
+
+            {
+                std::scoped_lock lock{_index_mtx};
+
+                // Forget files that no longer exist.
+                for(auto it = _records.begin(); it != _records.end();)
+                {
+                    if(live.count(it->first) == 0)
+                    {
+                        it = _records.erase(it);
+                    }
+                    else
+                    {
+                        ++it;
+                    }
+                }
+            }
+
+            task_group todo{_pool};
+
+            for(const fs::path& p : files)
+            {
+                todo.run(
+                    [this, &p, &on_written] { compress_file(p, on_written); });
+            }
+
+            todo.wait();
+            return _compressed_count;
+        }
+
+        void save_index()
+        {
+            if(_index_path.empty())
+            {
+                return;
+            }
+
+            std::ostringstream oss;
+
+            {
+                std::scoped_lock lock{_index_mtx};
+
+                for(const auto& [path, r] : _records)
+                {
+                    oss << to_hex(r._hash) << ' ' << r._size << ' '
+                        << r._mtime << '\t' << path << '\n';
+                }
+            }
+
+            write_file_atomically(_index_path, oss.str());
+        }
+    };
+} // namespace vrdi
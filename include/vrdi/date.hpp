@@ -0,0 +1,216 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace vrdi
+{
+    // Calendar date, parsed once from an entry's "Date" value. Compares in
+    // chronological order.
+    struct date
+    {
+        std::uint16_t _year;
+        std::uint8_t _month; // 1-12
+        std::uint8_t _day;   // 1-31
+
+        [[nodiscard]] constexpr std::uint32_t key() const noexcept
+        {
+            return (std::uint32_t(_year) << 16) |
+                   (std::uint32_t(_month) << 8) | _day;
+        }
+
+        [[nodiscard]] friend constexpr bool operator<(
+            const date& a, const date& b) noexcept
+        {
+            return a.key() < b.key();
+        }
+
+        [[nodiscard]] friend constexpr bool operator==(
+            const date& a, const date& b) noexcept
+        {
+            return a.key() == b.key();
+        }
+
+        [[nodiscard]] friend constexpr bool operator!=(
+            const date& a, const date& b) noexcept
+        {
+            return a.key() != b.key();
+        }
+
+        // 0 is Sunday.
+        [[nodiscard]] constexpr int weekday() const noexcept
+        {
+            constexpr int offsets[]{0, 3, 2, 5, 0, 3, 5, 1, 4, 6, 2, 4};
+
+            const int y = _year - (_month < 3 ? 1 : 0);
+            const int sum =
+                y + y / 4 - y / 100 + y / 400 + offsets[_month - 1] + _day;
+
+            return sum % 7;
+        }
+    };
+
+    namespace impl
+    {
+        inline constexpr std::string_view month_names[]{"january", "february",
+            "march", "april", "may", "june", "july", "august", "september",
+            "october", "november", "december"};
+
+        inline constexpr std::string_view month_abbreviations[]{"Jan", "Feb",
+            "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov",
+            "Dec"};
+
+        inline constexpr std::string_view weekday_abbreviations[]{
+            "Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"};
+
+        [[nodiscard]] constexpr bool is_digit(char c) noexcept
+        {
+            return c >= '0' && c <= '9';
+        }
+
+        [[nodiscard]] constexpr char to_lower(char c) noexcept
+        {
+            return c >= 'A' && c <= 'Z' ? char(c - 'A' + 'a') : c;
+        }
+
+        // Parses up to `max_digits` digits at `i`.
+        [[nodiscard]] constexpr std::optional<int> parse_number(
+            std::string_view x, std::size_t& i, std::size_t max_digits) noexcept
+        {
+            const std::size_t begin = i;
+            int result = 0;
+
+            while(i < x.size() && i - begin < max_digits && is_digit(x[i]))
+            {
+                result = result * 10 + (x[i] - '0');
+                ++i;
+            }
+
+            if(i == begin)
+            {
+                return std::nullopt;
+            }
+
+            return result;
+        }
+
+        [[nodiscard]] constexpr std::optional<int> parse_month(
+            std::string_view x, std::size_t& i) noexcept
+        {
+            const std::size_t begin = i;
+            while(i < x.size() && x[i] != ' ')
+            {
+                ++i;
+            }
+
+            const std::string_view word = x.substr(begin, i - begin);
+
+            for(int m = 0; m < 12; ++m)
+            {
+                const std::string_view name = month_names[m];
+                if(word.size() != name.size())
+                {
+                    continue;
+                }
+
+                bool equal = true;
+                for(std::size_t j = 0; equal && j < word.size(); ++j)
+                {
+                    equal = to_lower(word[j]) == name[j];
+                }
+
+                if(equal)
+                {
+                    return m + 1;
+                }
+            }
+
+            return std::nullopt;
+        }
+
+        [[nodiscard]] constexpr int days_in_month(
+            int year, int month) noexcept
+        {
+            constexpr int days[]{
+                31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+
+            const bool leap =
+                (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+
+            return month == 2 && leap ? 29 : days[month - 1];
+        }
+
+        constexpr void skip_spaces(std::string_view x, std::size_t& i) noexcept
+        {
+            while(i < x.size() && x[i] == ' ')
+            {
+                ++i;
+            }
+        }
+    } // namespace impl
+
+    // Parses dates written as "17 july 2016" (case-insensitive month name).
+    // Days that do not exist in their month, e.g. "31 february", are
+    // rejected.
+    [[nodiscard]] constexpr std::optional<date> parse_date(
+        std::string_view x) noexcept
+    {
+        std::size_t i = 0;
+
+        impl::skip_spaces(x, i);
+        const std::optional<int> d = impl::parse_number(x, i, 2);
+
+        impl::skip_spaces(x, i);
+        const std::optional<int> m = impl::parse_month(x, i);
+
+        impl::skip_spaces(x, i);
+        const std::optional<int> y = impl::parse_number(x, i, 4);
+
+        impl::skip_spaces(x, i);
+
+        if(!d || !m || !y || i != x.size() || *d < 1 ||
+            *d > impl::days_in_month(*y, *m))
+        {
+            return std::nullopt;
+        }
+
+        return date{std::uint16_t(*y), std::uint8_t(*m), std::uint8_t(*d)};
+    }
+
+    // "Sun, 17 Jul 2016 00:00:00 GMT", as required by RSS.
+    [[nodiscard]] inline std::string format_rfc822(const date& x)
+    {
+        char buf[32];
+        std::snprintf(buf, sizeof(buf), "%.3s, %02d %.3s %04d 00:00:00 GMT",
+            impl::weekday_abbreviations[x.weekday()].data(), x._day,
+            impl::month_abbreviations[x._month - 1].data(), x._year);
+
+        return buf;
+    }
+
+    // "2016-07-17T00:00:00Z", as required by Atom and sitemaps.
+    [[nodiscard]] inline std::string format_rfc3339(const date& x)
+    {
+        char buf[32];
+        std::snprintf(buf, sizeof(buf), "%04d-%02d-%02dT00:00:00Z", x._year,
+            x._month, x._day);
+
+        return buf;
+    }
+
+    // "2016-07-17T12:34:56Z", for exact times such as modification times.
+    [[nodiscard]] inline std::string format_rfc3339(std::time_t t)
+    {
+        std::tm tm{};
+        gmtime_r(&t, &tm);
+
+        char buf[32];
+        std::strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%SZ", &tm);
+
+        return buf;
+    }
+} // namespace vrdi
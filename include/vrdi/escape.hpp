@@ -0,0 +1,239 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#define VRDI_ESCAPE_SSE2 1
+#endif
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define VRDI_ESCAPE_AVX2 1
+#endif
+
+namespace vrdi
+{
+    namespace impl
+    {
+        // Characters handled by `escape_xml`: `&"'<>` are replaced by
+        // entities, '`' is dropped.
+        [[nodiscard]] constexpr bool is_xml_special(char c) noexcept
+        {
+            return c == '&' || c == '"' || c == '\'' || c == '<' ||
+                   c == '>' || c == '`';
+        }
+
+        [[nodiscard]] inline std::size_t find_xml_special_scalar(
+            const char* p, std::size_t n) noexcept
+        {
+            for(std::size_t i = 0; i < n; ++i)
+            {
+                if(is_xml_special(p[i]))
+                {
+                    return i;
+                }
+            }
+
+            return n;
+        }
+
+#ifdef VRDI_ESCAPE_SSE2
+        [[nodiscard]] inline std::size_t find_xml_special_sse2(
+            const char* p, std::size_t n) noexcept
+        {
+            const __m128i amp = _mm_set1_epi8('&');
+            const __m128i quot = _mm_set1_epi8('"');
+            const __m128i apos = _mm_set1_epi8('\'');
+            const __m128i lt = _mm_set1_epi8('<');
+            const __m128i gt = _mm_set1_epi8('>');
+            const __m128i tick = _mm_set1_epi8('`');
+
+            std::size_t i = 0;
+            for(; i + 16 <= n; i += 16)
+            {
+                const __m128i v =
+                    _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+
+                const __m128i hit = _mm_or_si128(
+                    _mm_or_si128(
+                        _mm_or_si128(_mm_cmpeq_epi8(v, amp),
+                            _mm_cmpeq_epi8(v, quot)),
+                        _mm_or_si128(
+                            _mm_cmpeq_epi8(v, apos), _mm_cmpeq_epi8(v, lt))),
+                    _mm_or_si128(
+                        _mm_cmpeq_epi8(v, gt), _mm_cmpeq_epi8(v, tick)));
+
+                const int mask = _mm_movemask_epi8(hit);
+                if(mask != 0)
+                {
+                    return i + static_cast<std::size_t>(__builtin_ctz(
+                                   static_cast<unsigned int>(mask)));
+                }
+            }
+
+            return i + find_xml_special_scalar(p + i, n - i);
+        }
+#endif
+
+#ifdef VRDI_ESCAPE_AVX2
+        [[nodiscard]] __attribute__((target("avx2"))) inline std::size_t
+        find_xml_special_avx2(const char* p, std::size_t n) noexcept
+        {
+            const __m256i amp = _mm256_set1_epi8('&');
+            const __m256i quot = _mm256_set1_epi8('"');
+            const __m256i apos = _mm256_set1_epi8('\'');
+            const __m256i lt = _mm256_set1_epi8('<');
+            const __m256i gt = _mm256_set1_epi8('>');
+            const __m256i tick = _mm256_set1_epi8('`');
+
+            std::size_t i = 0;
+            for(; i + 32 <= n; i += 32)
+            {
+                const __m256i v = _mm256_loadu_si256(
+                    reinterpret_cast<const __m256i*>(p + i));
+
+                const __m256i hit = _mm256_or_si256(
+                    _mm256_or_si256(
+                        _mm256_or_si256(_mm256_cmpeq_epi8(v, amp),
+                            _mm256_cmpeq_epi8(v, quot)),
+                        _mm256_or_si256(_mm256_cmpeq_epi8(v, apos),
+                            _mm256_cmpeq_epi8(v, lt))),
+                    _mm256_or_si256(_mm256_cmpeq_epi8(v, gt),
+                        _mm256_cmpeq_epi8(v, tick)));
+
+                const int mask = _mm256_movemask_epi8(hit);
+                if(mask != 0)
+                {
+                    return i + static_cast<std::size_t>(__builtin_ctz(
+                                   static_cast<unsigned int>(mask)));
+                }
+            }
+
+            return i + find_xml_special_sse2(p + i, n - i);
+        }
+#endif
+
+        using find_xml_special_fn = std::size_t (*)(const char*, std::size_t);
+
+        // Picks the widest kernel supported by the running CPU, once.
+        [[nodiscard]] inline find_xml_special_fn find_xml_special() noexcept
+        {
+            static const find_xml_special_fn result = []
+            {
+#ifdef VRDI_ESCAPE_AVX2
+                if(__builtin_cpu_supports("avx2"))
+                {
+                    return &find_xml_special_avx2;
+                }
+#endif
+
+#ifdef VRDI_ESCAPE_SSE2
+                return &find_xml_special_sse2;
+#else
+                return &find_xml_special_scalar;
+#endif
+            }();
+
+            return result;
+        }
+
+        [[nodiscard]] constexpr std::string_view xml_entity(char c) noexcept
+        {
+            switch(c)
+            {
+                case '&': return "&amp;";
+                case '"': return "&quot;";
+                case '\'': return "&apos;";
+                case '<': return "&lt;";
+                case '>': return "&gt;";
+                default: return ""; // '`' is dropped.
+            }
+        }
+    } // namespace impl
+
+    // Appends `x` to `out`, replacing `&"'<>` with XML entities and dropping
+    // backticks. Runs of ordinary characters are found with SIMD and copied
+    // in bulk.
+    inline void escape_xml_to(std::string& out, std::string_view x)
+    {
+        const impl::find_xml_special_fn find = impl::find_xml_special();
+
+        const char* p = x.data();
+        std::size_t n = x.size();
+
+        while(n > 0)
+        {
+            const std::size_t clean = find(p, n);
+            out.append(p, clean);
+
+            if(clean == n)
+            {
+                break;
+            }
+
+            out += impl::xml_entity(p[clean]);
+            p += clean + 1;
+            n -= clean + 1;
+        }
+    }
+
+    [[nodiscard]] inline std::string escape_xml(std::string_view x)
+    {
+        std::string result;
+        result.reserve(x.size() + x.size() / 8);
+        escape_xml_to(result, x);
+
+        return result;
+    }
+
+    // Escapes a value for use inside a quoted HTML attribute. The XML
+    // entities are valid HTML5, so the same kernel is used.
+    [[nodiscard]] inline std::string escape_html_attribute(std::string_view x)
+    {
+        return escape_xml(x);
+    }
+
+    // Reverts the escaping of text and code produced by Markdown renderers:
+    // the XML entities and `&#39;`. Other entities are kept as they are.
+    [[nodiscard]] inline std::string unescape_html(std::string_view x)
+    {
+        static const std::pair<std::string_view, char> entities[]{
+            {"&lt;", '<'}, {"&gt;", '>'}, {"&amp;", '&'}, {"&quot;", '"'},
+            {"&#39;", '\''}, {"&apos;", '\''}};
+
+        std::string result;
+        result.reserve(x.size());
+
+        for(std::size_t i = 0; i < x.size(); ++i)
+        {
+            if(x[i] != '&')
+            {
+                result += x[i];
+                continue;
+            }
+
+            bool replaced = false;
+            for(const auto& [entity, c] : entities)
+            {
+                if(x.substr(i, entity.size()) == entity)
+                {
+                    result += c;
+                    i += entity.size() - 1;
+                    replaced = true;
+                    break;
+                }
+            }
+
+            if(!replaced)
+            {
+                result += '&';
+            }
+        }
+
+        return result;
+    }
+} // namespace vrdi
@@ -0,0 +1,175 @@
+#pragma once
+
+#include "./escape.hpp"
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace vrdi
+{
+    struct feed_channel
+    {
+        std::string_view _title;
+        std::string_view _description;
+        std::string_view _author;
+        std::string_view _language;
+
+        // Website root, and absolute URL of the feed itself.
+        std::string_view _link;
+        std::string_view _self_link;
+
+        // RFC 3339 date of the latest change, for Atom feeds without items.
+        std::string_view _updated;
+    };
+
+    // Every field must outlive the call that writes it. Dates are already
+    // formatted: RFC 822 for RSS, RFC 3339 for Atom.
+    struct feed_item
+    {
+        std::string_view _title;
+        std::string_view _link;
+        std::string_view _rss_date;
+        std::string_view _atom_date;
+
+        // Rendered HTML, written as CDATA.
+        std::string_view _content;
+    };
+
+    namespace impl
+    {
+        inline void append_element(
+            std::string& out, std::string_view tag, std::string_view text)
+        {
+            out += '<';
+            out += tag;
+            out += '>';
+            escape_xml_to(out, text);
+            out += "</";
+            out += tag;
+            out += ">\n";
+        }
+
+        // Unlike `escape_xml`, keeps backticks: code blocks need them.
+        inline void append_cdata(std::string& out, std::string_view text)
+        {
+            out += "<![CDATA[";
+
+            for(std::size_t end; (end = text.find("]]>")) != text.npos;)
+            {
+                out.append(text.data(), end + 2);
+                out += "]]><![CDATA[";
+                text.remove_prefix(end + 2);
+            }
+
+            out += text;
+            out += "]]>";
+        }
+
+        [[nodiscard]] inline std::size_t estimate_feed_size(
+            const std::vector<feed_item>& items) noexcept
+        {
+            std::size_t result = 1024;
+
+            for(const feed_item& i : items)
+            {
+                result += 256 + i._title.size() + 3 * i._link.size() +
+                          i._content.size();
+            }
+
+            return result;
+        }
+    } // namespace impl
+
+    // Writes an RSS 2.0 document in a single pass, with items in the given
+    // order.
+    [[nodiscard]] inline std::string write_rss(
+        const feed_channel& c, const std::vector<feed_item>& items)
+    {
+        std::string out;
+        out.reserve(impl::estimate_feed_size(items));
+
+        out += "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+               "<rss version=\"2.0\" "
+               "xmlns:atom=\"http://www.w3.org/2005/Atom\">\n<channel>\n";
+
+        impl::append_element(out, "title", c._title);
+        impl::append_element(out, "description", c._description);
+        impl::append_element(out, "link", c._link);
+        impl::append_element(out, "language", c._language);
+
+        out += "<atom:link href=\"";
+        escape_xml_to(out, c._self_link);
+        out += "\" rel=\"self\" type=\"application/rss+xml\" />\n";
+
+        for(const feed_item& i : items)
+        {
+            out += "<item>\n";
+            impl::append_element(out, "title", i._title);
+            impl::append_element(out, "link", i._link);
+            impl::append_element(out, "guid", i._link);
+            impl::append_element(out, "pubDate", i._rss_date);
+
+            out += "<description>";
+            impl::append_cdata(out, i._content);
+            out += "</description>\n</item>\n";
+        }
+
+        out += "</channel>\n</rss>\n";
+        return out;
+    }
+
+    // Writes an Atom 1.0 document in a single pass, with items in the given
+    // order. The feed's `updated` date is taken from the first item.
+    [[nodiscard]] inline std::string write_atom(
+        const feed_channel& c, const std::vector<feed_item>& items)
+    {
+        std::string out;
+        out.reserve(impl::estimate_feed_size(items));
+
+        out += "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+               "<feed xmlns=\"http://www.w3.org/2005/Atom\" xml:lang=\"";
+        escape_xml_to(out, c._language);
+        out += "\">\n";
+
+        impl::append_element(out, "title", c._title);
+        impl::append_element(out, "subtitle", c._description);
+        // Unique per feed, as the main feed and every tag feed share `_link`.
+        impl::append_element(out, "id", c._self_link);
+
+        out += "<link href=\"";
+        escape_xml_to(out, c._link);
+        out += "\" />\n<link href=\"";
+        escape_xml_to(out, c._self_link);
+        out += "\" rel=\"self\" type=\"application/atom+xml\" />\n";
+
+        out += "<author>";
+        impl::append_element(out, "name", c._author);
+        out += "</author>\n";
+
+        // Required by RFC 4287, even without entries.
+        impl::append_element(out, "updated",
+            items.empty() ? c._updated : items.front()._atom_date);
+
+        for(const feed_item& i : items)
+        {
+            out += "<entry>\n";
+            impl::append_element(out, "title", i._title);
+            impl::append_element(out, "id", i._link);
+
+            out += "<link href=\"";
+            escape_xml_to(out, i._link);
+            out += "\" />\n";
+
+            impl::append_element(out, "updated", i._atom_date);
+
+            out += "<content type=\"html\">";
+            impl::append_cdata(out, i._content);
+            out += "</content>\n</entry>\n";
+        }
+
+        out += "</feed>\n";
+        return out;
+    }
+} // namespace vrdi
@@ -0,0 +1,179 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <system_error>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace vrdi
+{
+    // Recursive file system watcher built on `inotify`. Only available on
+    // Linux: elsewhere `supported` returns `false` and no change is ever
+    // reported.
+    class file_watcher
+    {
+    private:
+#ifdef __linux__
+        int _fd{-1};
+        std::unordered_map<int, std::filesystem::path> _watched;
+
+        void add_single(const std::filesystem::path& dir)
+        {
+            constexpr std::uint32_t mask = IN_CLOSE_WRITE | IN_MOVED_TO |
+                                           IN_MOVED_FROM | IN_CREATE |
+                                           IN_DELETE | IN_DELETE_SELF;
+
+            const int wd = inotify_add_watch(_fd, dir.c_str(), mask);
+            if(wd >= 0)
+            {
+                _watched[wd] = dir;
+            }
+        }
+
+        // Reads all currently available events, appending changed paths.
+        void drain(std::unordered_set<std::string>& changed)
+        {
+            alignas(inotify_event) char buf[16 * 1024];
+
+            const ssize_t n = read(_fd, buf, sizeof(buf));
+            if(n <= 0)
+            {
+                return;
+            }
+
+            for(ssize_t i = 0; i < n;)
+            {
+                const auto* e = reinterpret_cast<const inotify_event*>(buf + i);
+                i += static_cast<ssize_t>(sizeof(inotify_event) + e->len);
+
+                const auto it = _watched.find(e->wd);
+                if(it == _watched.end())
+                {
+                    continue;
+                }
+
+                if(e->mask & IN_IGNORED)
+                {
+                    _watched.erase(it);
+                    continue;
+                }
+
+                const std::filesystem::path p =
+                    e->len > 0 ? it->second / e->name : it->second;
+
+                // Watch newly created folders as well.
+                if((e->mask & IN_ISDIR) &&
+                    (e->mask & (IN_CREATE | IN_MOVED_TO)))
+                {
+                    add_recursive(p);
+                }
+
+                changed.insert(p.generic_string());
+            }
+        }
+
+        [[nodiscard]] bool poll_for(std::chrono::milliseconds timeout)
+        {
+            pollfd pfd{_fd, POLLIN, 0};
+            return poll(&pfd, 1, static_cast<int>(timeout.count())) > 0;
+        }
+#endif
+
+    public:
+        file_watcher()
+        {
+#ifdef __linux__
+            _fd = inotify_init1(IN_CLOEXEC);
+#endif
+        }
+
+        ~file_watcher()
+        {
+#ifdef __linux__
+            if(_fd >= 0)
+            {
+                close(_fd);
+            }
+#endif
+        }
+
+        file_watcher(const file_watcher&) = delete;
+        file_watcher& operator=(const file_watcher&) = delete;
+
+        [[nodiscard]] bool supported() const noexcept
+        {
+#ifdef __linux__
+            return _fd >= 0;
+#else
+            return false;
+#endif
+        }
+
+        void add_recursive(const std::filesystem::path& dir)
+        {
+#ifdef __linux__
+            if(!supported() || !std::filesystem::is_directory(dir))
+            {
+                return;
+            }
+
+            add_single(dir);
+
+            std::error_code ec;
+            for(const auto& e :
+                std::filesystem::recursive_directory_iterator{dir, ec})
+            {
+                if(e.is_directory())
+                {
+                    add_single(e.path());
+                }
+            }
+#else
+            (void)dir;
+#endif
+        }
+
+        // Blocks until something changes, then keeps collecting changes until
+        // nothing happens for `quiet_period`, so that editors saving several
+        // files (or writing a file in several steps) trigger a single rebuild.
+        [[nodiscard]] std::vector<std::string> wait_for_changes(
+            std::chrono::milliseconds quiet_period)
+        {
+            std::unordered_set<std::string> changed;
+
+#ifdef __linux__
+            if(!supported())
+            {
+                return {};
+            }
+
+            while(changed.empty())
+            {
+                if(poll_for(std::chrono::milliseconds{-1}))
+                {
+                    drain(changed);
+                }
+            }
+
+            while(poll_for(quiet_period))
+            {
+                drain(changed);
+            }
+#else
+            (void)quiet_period;
+#endif
+
+            return {changed.begin(), changed.end()};
+        }
+    };
+} // namespace vrdi
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+namespace vrdi
+{
+    // Incremental 64-bit FNV-1a hasher. Not cryptographic, but more than
+    // enough to detect changes in source files and rendered outputs.
+    class hasher
+    {
+    private:
+        std::uint64_t _state{14695981039346656037ull};
+
+    public:
+        hasher& operator()(std::string_view x) noexcept
+        {
+            for(const char c : x)
+            {
+                _state ^= static_cast<unsigned char>(c);
+                _state *= 1099511628211ull;
+            }
+
+            // Separate consecutive inputs, so that `("ab", "c")` and
+            // `("a", "bc")` produce different digests.
+            _state ^= 0xff;
+            _state *= 1099511628211ull;
+
+            return *this;
+        }
+
+        hasher& operator()(std::uint64_t x) noexcept
+        {
+            const char* bytes = reinterpret_cast<const char*>(&x);
+            return (*this)(std::string_view{bytes, sizeof(x)});
+        }
+
+        [[nodiscard]] std::uint64_t digest() const noexcept
+        {
+            return _state;
+        }
+    };
+
+    [[nodiscard]] inline std::uint64_t hash_bytes(std::string_view x) noexcept
+    {
+        return hasher{}(x).digest();
+    }
+
+    [[nodiscard]] inline std::string to_hex(std::uint64_t x)
+    {
+        constexpr const char* digits = "0123456789abcdef";
+
+        std::string result(16, '0');
+        for(int i = 15; i >= 0; --i, x >>= 4)
+        {
+            result[static_cast<std::size_t>(i)] = digits[x & 0xf];
+        }
+
+        return result;
+    }
+
+    // Inverse of `to_hex`. Returns `std::nullopt` unless all of `x` is a
+    // hexadecimal number that fits, e.g. for a truncated index line.
+    [[nodiscard]] inline std::optional<std::uint64_t> parse_hex(
+        std::string_view x) noexcept
+    {
+        std::uint64_t result;
+        const auto [end, ec] =
+            std::from_chars(x.data(), x.data() + x.size(), result, 16);
+
+        if(x.empty() || ec != std::errc{} || end != x.data() + x.size())
+        {
+            return std::nullopt;
+        }
+
+        return result;
+    }
+
+    [[nodiscard]] inline std::string read_file(const std::filesystem::path& p)
+    {
+        std::ifstream ifs{p, std::ios::binary};
+        return std::string{std::istreambuf_iterator<char>(ifs),
+            std::istreambuf_iterator<char>()};
+    }
+
+    // Writes `contents` to a temporary file next to `p` and renames it into
+    // place, so that a crash never leaves a truncated `p` behind. Returns
+    // `false` if the file could not be written.
+    inline bool write_file_atomically(
+        const std::filesystem::path& p, std::string_view contents)
+    {
+        std::filesystem::path temp = p;
+        temp += ".tmp";
+
+        bool written;
+
+        {
+            std::ofstream o{temp, std::ios::binary | std::ios::trunc};
+            o.write(contents.data(),
+                static_cast<std::streamsize>(contents.size()));
+
+            o.close();
+            written = static_cast<bool>(o);
+        }
+
+        std::error_code ec;
+        if(written)
+        {
+            std::filesystem::rename(temp, p, ec);
+        }
+
+        if(!written || ec)
+        {
+            std::filesystem::remove(temp, ec);
+            return false;
+        }
+
+        return true;
+    }
+
+    // Feeds the relative path and contents of every regular file under `dir`
+    // into `h`, in a deterministic order.
+    inline void hash_tree(hasher& h, const std::filesystem::path& dir)
+    {
+        namespace fs = std::filesystem;
+
+        if(!fs::is_directory(dir))
+        {
+            return;
+        }
+
+        std::vector<fs::path> files;
+        for(const auto& e : fs::recursive_directory_iterator{dir})
+        {
+            if(e.is_regular_file())
+            {
+                files.emplace_back(e.path());
+            }
+        }
+
+        std::sort(files.begin(), files.end());
+
+        for(const fs::path& p : files)
+        {
+            h(p.lexically_relative(dir).generic_string());
+            h(read_file(p));
+        }
+    }
+} // namespace vrdi
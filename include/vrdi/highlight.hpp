@@ -0,0 +1,925 @@
+#pragma once
+
+#include "./escape.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace vrdi
+{
+    // Bump whenever the highlighted output changes for the same code.
+    inline constexpr std::string_view highlighter_version{"vrdi-highlight-1"};
+
+    // Lexical rules of a highlighted language. Every language is described
+    // by data only; the tokenizer is shared.
+    struct language
+    {
+        // Names accepted in fenced code blocks. The first one is canonical.
+        std::vector<std::string_view> _names;
+
+        // Sorted on construction by `find_language`'s table.
+        std::vector<std::string_view> _keywords;
+        std::vector<std::string_view> _built_ins;
+
+        std::string_view _line_comment;
+        std::string_view _block_comment_begin;
+        std::string_view _block_comment_end;
+
+        // Characters opening strings with backslash escapes, and opening
+        // strings without escapes (e.g. D's `...` or shell '...').
+        std::string_view _quotes;
+        std::string_view _raw_quotes;
+
+        enum class raw_strings
+        {
+            none,
+            cpp,  // R"delim(...)delim", also with an encoding prefix
+            rust, // r"...", r#"..."#, br"..."
+            d     // r"..."
+        };
+
+        raw_strings _raw_strings{raw_strings::none};
+
+        // '\'' opens short character literals only, so that Rust lifetimes
+        // and C++14 digit separators are left alone.
+        bool _char_literals{false};
+
+        // '#' at the start of a line begins a (continued) preprocessor line.
+        bool _preprocessor{false};
+
+        // `#[...]` and `#![...]` are attributes (Rust).
+        bool _hash_attributes{false};
+
+        // `$name`, `${...}` and `$1` are variables; comments only start at
+        // the beginning of a word (shell).
+        bool _shell{false};
+
+        // Tags, attributes and comments instead of code (HTML, XML).
+        bool _markup{false};
+    };
+
+    namespace impl
+    {
+        // Class names understood by `resources/js/styles/github.css`.
+        namespace css
+        {
+            inline constexpr std::string_view keyword{"keyword"};
+            inline constexpr std::string_view built_in{"built_in"};
+            inline constexpr std::string_view string{"string"};
+            inline constexpr std::string_view number{"number"};
+            inline constexpr std::string_view comment{"comment"};
+            inline constexpr std::string_view preprocessor{"preprocessor"};
+            inline constexpr std::string_view variable{"variable"};
+            inline constexpr std::string_view tag{"tag"};
+            inline constexpr std::string_view title{"title"};
+            inline constexpr std::string_view attribute{"attribute"};
+            inline constexpr std::string_view value{"value"};
+            inline constexpr std::string_view doctype{"doctype"};
+        } // namespace css
+
+        [[nodiscard]] constexpr bool is_ident_start(char c) noexcept
+        {
+            return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+                   c == '_';
+        }
+
+        [[nodiscard]] constexpr bool is_decimal_digit(char c) noexcept
+        {
+            return c >= '0' && c <= '9';
+        }
+
+        [[nodiscard]] constexpr bool is_ident(char c) noexcept
+        {
+            return is_ident_start(c) || is_decimal_digit(c);
+        }
+
+        [[nodiscard]] constexpr bool is_space(char c) noexcept
+        {
+            return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+        }
+
+        [[nodiscard]] inline bool contains(
+            const std::vector<std::string_view>& sorted, std::string_view x)
+        {
+            return std::binary_search(sorted.begin(), sorted.end(), x);
+        }
+
+        // Escapes only what is needed inside `<code>`. Unlike `escape_xml`,
+        // backticks and quotes are kept verbatim.
+        inline void append_code_text(std::string& out, std::string_view x)
+        {
+            for(const char c : x)
+            {
+                switch(c)
+                {
+                    case '&': out += "&amp;"; break;
+                    case '<': out += "&lt;"; break;
+                    case '>': out += "&gt;"; break;
+                    default: out += c;
+                }
+            }
+        }
+
+        inline void append_span(
+            std::string& out, std::string_view css_class, std::string_view x)
+        {
+            out += "<span class=\"";
+            out += css_class;
+            out += "\">";
+            append_code_text(out, x);
+            out += "</span>";
+        }
+
+        // Shared tokenizer, driven by a `language`'s rules.
+        class code_highlighter
+        {
+        private:
+            const language& _l;
+            std::string_view _src;
+            std::string& _out;
+            std::size_t _i{0};
+
+            // Start of the pending run of plain text.
+            std::size_t _plain_begin{0};
+
+            [[nodiscard]] bool at(std::string_view x) const noexcept
+            {
+                return !x.empty() && _src.substr(_i, x.size()) == x;
+            }
+
+            [[nodiscard]] char peek(std::size_t offset = 0) const noexcept
+            {
+                return _i + offset < _src.size() ? _src[_i + offset] : '\0';
+            }
+
+            [[nodiscard]] bool at_line_start() const noexcept
+            {
+                for(std::size_t j = _i; j-- > 0;)
+                {
+                    if(_src[j] == '\n')
+                    {
+                        return true;
+                    }
+
+                    if(_src[j] != ' ' && _src[j] != '\t')
+                    {
+                        return false;
+                    }
+                }
+
+                return true;
+            }
+
+            void flush_plain(std::size_t end)
+            {
+                append_code_text(
+                    _out, _src.substr(_plain_begin, end - _plain_begin));
+            }
+
+            // Emits `[begin, end)` as a span and resumes after it.
+            void emit(
+                std::string_view css_class, std::size_t begin, std::size_t end)
+            {
+                flush_plain(begin);
+                append_span(_out, css_class, _src.substr(begin, end - begin));
+
+                _i = end;
+                _plain_begin = end;
+            }
+
+            [[nodiscard]] std::size_t find_or_end(
+                std::string_view x, std::size_t from) const noexcept
+            {
+                const std::size_t pos = _src.find(x, from);
+                return pos == std::string_view::npos ? _src.size()
+                                                     : pos + x.size();
+            }
+
+            [[nodiscard]] std::size_t line_end(std::size_t from) const noexcept
+            {
+                const std::size_t pos = _src.find('\n', from);
+                return pos == std::string_view::npos ? _src.size() : pos;
+            }
+
+            [[nodiscard]] std::size_t string_end(
+                std::size_t from, char quote, bool escapes) const noexcept
+            {
+                for(std::size_t j = from; j < _src.size(); ++j)
+                {
+                    if(escapes && _src[j] == '\\')
+                    {
+                        ++j;
+                    }
+                    else if(_src[j] == quote)
+                    {
+                        return j + 1;
+                    }
+                }
+
+                return _src.size();
+            }
+
+            // End of a character literal starting at `_i`, or `_i` if this
+            // is not one (e.g. a Rust lifetime).
+            [[nodiscard]] std::size_t char_literal_end() const noexcept
+            {
+                const std::size_t limit = std::min(_src.size(), _i + 12);
+
+                for(std::size_t j = _i + 1; j < limit; ++j)
+                {
+                    if(_src[j] == '\\')
+                    {
+                        ++j;
+                    }
+                    else if(_src[j] == '\'')
+                    {
+                        // Only escapes may span more than one character.
+                        return (j == _i + 2 || _src[_i + 1] == '\\') ? j + 1
+                                                                     : _i;
+                    }
+                    else if(_src[j] == '\n')
+                    {
+                        break;
+                    }
+                }
+
+                return _i;
+            }
+
+            // Raw string starting at the identifier `[begin, _i)`, if any.
+            [[nodiscard]] std::size_t raw_string_end(
+                std::string_view prefix) const noexcept
+            {
+                using raw = language::raw_strings;
+
+                if(_l._raw_strings == raw::cpp &&
+                    (prefix == "R" || prefix == "u8R" || prefix == "uR" ||
+                        prefix == "UR" || prefix == "LR") &&
+                    peek() == '"')
+                {
+                    const std::size_t open = _src.find('(', _i);
+                    if(open == std::string_view::npos)
+                    {
+                        return _i;
+                    }
+
+                    std::string closing{")"};
+                    closing += _src.substr(_i + 1, open - _i - 1);
+                    closing += '"';
+
+                    return find_or_end(closing, open);
+                }
+
+                if(_l._raw_strings == raw::rust &&
+                    (prefix == "r" || prefix == "br") &&
+                    (peek() == '"' || peek() == '#'))
+                {
+                    std::size_t j = _i;
+                    while(j < _src.size() && _src[j] == '#')
+                    {
+                        ++j;
+                    }
+
+                    if(j == _src.size() || _src[j] != '"')
+                    {
+                        return _i;
+                    }
+
+                    std::string closing{"\""};
+                    closing.append(j - _i, '#');
+
+                    return find_or_end(closing, j + 1);
+                }
+
+                if(_l._raw_strings == raw::d && prefix == "r" && peek() == '"')
+                {
+                    return string_end(_i + 1, '"', false);
+                }
+
+                return _i;
+            }
+
+            // String with an encoding prefix, e.g. `u8"..."` or `b"..."`.
+            [[nodiscard]] bool is_string_prefix(
+                std::string_view prefix) const noexcept
+            {
+                if(peek() != '"' && peek() != '\'')
+                {
+                    return false;
+                }
+
+                using raw = language::raw_strings;
+
+                if(_l._raw_strings == raw::cpp)
+                {
+                    return prefix == "u8" || prefix == "u" || prefix == "U" ||
+                           prefix == "L";
+                }
+
+                return _l._raw_strings == raw::rust && prefix == "b";
+            }
+
+            void identifier()
+            {
+                const std::size_t begin = _i;
+                while(_i < _src.size() && is_ident(_src[_i]))
+                {
+                    ++_i;
+                }
+
+                const std::string_view word = _src.substr(begin, _i - begin);
+
+                if(const std::size_t end = raw_string_end(word); end != _i)
+                {
+                    emit(css::string, begin, end);
+                }
+                else if(is_string_prefix(word))
+                {
+                    const char quote = _src[_i];
+                    emit(css::string, begin, string_end(_i + 1, quote, true));
+                }
+                else if(contains(_l._keywords, word))
+                {
+                    emit(css::keyword, begin, _i);
+                }
+                else if(contains(_l._built_ins, word))
+                {
+                    emit(css::built_in, begin, _i);
+                }
+            }
+
+            void number()
+            {
+                const std::size_t begin = _i++;
+
+                while(_i < _src.size())
+                {
+                    const char c = _src[_i];
+                    const char prev = _src[_i - 1];
+
+                    const bool hex = _src[begin] == '0' && _i - begin >= 2 &&
+                                     (_src[begin + 1] == 'x' ||
+                                         _src[begin + 1] == 'X');
+
+                    // `e` is a digit in hexadecimal literals.
+                    const bool exponent_sign =
+                        (c == '+' || c == '-') &&
+                        (prev == 'p' || prev == 'P' ||
+                            (!hex && (prev == 'e' || prev == 'E')));
+
+                    const bool separator =
+                        c == '\'' && _l._char_literals && is_ident(peek(1));
+
+                    if(!is_ident(c) && c != '.' && !exponent_sign &&
+                        !separator)
+                    {
+                        break;
+                    }
+
+                    // `1..2` ranges (Rust, D).
+                    if(c == '.' && peek(1) == '.')
+                    {
+                        break;
+                    }
+
+                    ++_i;
+                }
+
+                emit(css::number, begin, _i);
+            }
+
+            // A lone `$` is left as plain text.
+            void shell_variable()
+            {
+                const std::size_t begin = _i++;
+
+                if(peek() == '{')
+                {
+                    emit(css::variable, begin, find_or_end("}", _i));
+                }
+                else if(is_ident_start(peek()))
+                {
+                    while(_i < _src.size() && is_ident(_src[_i]))
+                    {
+                        ++_i;
+                    }
+
+                    emit(css::variable, begin, _i);
+                }
+                else if(is_decimal_digit(peek()) ||
+                        std::string_view{"@#?*$"}.find(peek()) !=
+                            std::string_view::npos)
+                {
+                    emit(css::variable, begin, _i + 1);
+                }
+            }
+
+            [[nodiscard]] bool comment_allowed_here() const noexcept
+            {
+                return !_l._shell || _i == 0 || is_space(_src[_i - 1]);
+            }
+
+            void step()
+            {
+                const char c = _src[_i];
+
+                if(at(_l._block_comment_begin))
+                {
+                    emit(css::comment, _i,
+                        find_or_end(_l._block_comment_end,
+                            _i + _l._block_comment_begin.size()));
+                }
+                else if(_l._preprocessor && c == '#' && at_line_start())
+                {
+                    // Continued lines end with a backslash.
+                    std::size_t end = line_end(_i);
+                    while(end < _src.size() && end > 0 &&
+                          _src[end - 1] == '\\')
+                    {
+                        end = line_end(end + 1);
+                    }
+
+                    emit(css::preprocessor, _i, end);
+                }
+                else if(_l._hash_attributes && c == '#' &&
+                        (peek(1) == '[' || (peek(1) == '!' && peek(2) == '[')))
+                {
+                    emit(css::preprocessor, _i, find_or_end("]", _i));
+                }
+                else if(at(_l._line_comment) && comment_allowed_here())
+                {
+                    emit(css::comment, _i, line_end(_i));
+                }
+                else if(_l._quotes.find(c) != std::string_view::npos)
+                {
+                    if(c == '\'' && _l._char_literals)
+                    {
+                        if(const std::size_t end = char_literal_end();
+                            end != _i)
+                        {
+                            emit(css::string, _i, end);
+                            return;
+                        }
+
+                        ++_i;
+                        return;
+                    }
+
+                    emit(css::string, _i, string_end(_i + 1, c, true));
+                }
+                else if(_l._raw_quotes.find(c) != std::string_view::npos)
+                {
+                    emit(css::string, _i, string_end(_i + 1, c, false));
+                }
+                else if(_l._shell && c == '$')
+                {
+                    shell_variable();
+                }
+                else if(is_ident_start(c))
+                {
+                    identifier();
+                }
+                else if(is_decimal_digit(c) ||
+                        (c == '.' && is_decimal_digit(peek(1)) &&
+                            (_i == 0 || (!is_ident(_src[_i - 1]) &&
+                                            _src[_i - 1] != '.'))))
+                {
+                    number();
+                }
+                else
+                {
+                    ++_i;
+                }
+            }
+
+        public:
+            code_highlighter(
+                const language& l, std::string_view src, std::string& out)
+                : _l{l}, _src{src}, _out{out}
+            {
+            }
+
+            void run()
+            {
+                while(_i < _src.size())
+                {
+                    step();
+                }
+
+                flush_plain(_src.size());
+            }
+        };
+
+        // HTML/XML: `<tag attr="value">`, comments and doctypes. Contents of
+        // `<script>` are highlighted as `script_language`, if given.
+        inline void highlight_markup(std::string_view src, std::string& out,
+            const language* script_language);
+
+        inline void highlight_code(
+            const language& l, std::string_view src, std::string& out)
+        {
+            code_highlighter{l, src, out}.run();
+        }
+    } // namespace impl
+
+    // Looks up a language by any of its names, case-sensitively as written
+    // after the opening fence. Returns `nullptr` for unsupported languages.
+    [[nodiscard]] inline const language* find_language(std::string_view name)
+    {
+        using raw = language::raw_strings;
+
+        static const std::vector<language> languages = []
+        {
+            std::vector<language> result;
+
+            language cpp;
+            cpp._names = {"cpp", "c++", "cxx", "hpp", "c", "h"};
+            cpp._keywords = {"alignas", "alignof", "and", "asm", "auto",
+                "bool", "break", "case", "catch", "char", "char16_t",
+                "char32_t", "char8_t", "class", "co_await", "co_return",
+                "co_yield", "concept", "const", "const_cast", "consteval",
+                "constexpr", "constinit", "continue", "decltype", "default",
+                "delete", "do", "double", "dynamic_cast", "else", "enum",
+                "explicit", "export", "extern", "false", "final", "float",
+                "for", "friend", "goto", "if", "inline", "int", "long",
+                "mutable", "namespace", "new", "noexcept", "not", "nullptr",
+                "operator", "or", "override", "private", "protected",
+                "public", "register", "reinterpret_cast", "requires",
+                "return", "short", "signed", "sizeof", "static",
+                "static_assert", "static_cast", "struct", "switch",
+                "template", "this", "thread_local", "throw", "true", "try",
+                "typedef", "typeid", "typename", "union", "unsigned", "using",
+                "virtual", "void", "volatile", "wchar_t", "while"};
+            cpp._built_ins = {"std", "string", "string_view", "vector",
+                "array", "map", "unordered_map", "set", "unordered_set",
+                "tuple", "pair", "optional", "variant", "any", "function",
+                "unique_ptr", "shared_ptr", "weak_ptr", "size_t",
+                "ptrdiff_t", "int8_t", "int16_t", "int32_t", "int64_t",
+                "uint8_t", "uint16_t", "uint32_t", "uint64_t", "cout", "cin",
+                "cerr", "endl", "printf", "move", "forward", "declval",
+                "make_unique", "make_shared", "make_tuple", "get", "apply",
+                "integral_constant", "integer_sequence", "index_sequence",
+                "enable_if_t", "decay_t", "is_same", "is_same_v", "thread",
+                "mutex", "atomic"};
+            cpp._line_comment = "//";
+            cpp._block_comment_begin = "/*";
+            cpp._block_comment_end = "*/";
+            cpp._quotes = "\"'";
+            cpp._raw_strings = raw::cpp;
+            cpp._char_literals = true;
+            cpp._preprocessor = true;
+            result.emplace_back(std::move(cpp));
+
+            language bash;
+            bash._names = {"bash", "sh", "shell", "zsh", "console"};
+            bash._keywords = {"if", "then", "else", "elif", "fi", "for",
+                "while", "until", "do", "done", "case", "esac", "in",
+                "function", "return", "break", "continue", "local", "export",
+                "readonly", "declare", "select", "time"};
+            bash._built_ins = {"echo", "cd", "pwd", "exit", "source", "set",
+                "unset", "shift", "read", "printf", "test", "eval", "exec",
+                "trap", "alias", "cat", "ls", "rm", "mkdir", "cp", "mv",
+                "grep", "sed", "awk", "find", "sudo", "make", "cmake", "git",
+                "chmod", "touch"};
+            bash._line_comment = "#";
+            bash._quotes = "\"`";
+            bash._raw_quotes = "'";
+            bash._shell = true;
+            result.emplace_back(std::move(bash));
+
+            language rust;
+            rust._names = {"rust", "rs"};
+            rust._keywords = {"as", "async", "await", "break", "const",
+                "continue", "crate", "dyn", "else", "enum", "extern", "false",
+                "fn", "for", "if", "impl", "in", "let", "loop", "match", "mod",
+                "move", "mut", "pub", "ref", "return", "self", "Self",
+                "static", "struct", "super", "trait", "true", "type",
+                "unsafe", "use", "where", "while"};
+            rust._built_ins = {"i8", "i16", "i32", "i64", "i128", "isize",
+                "u8", "u16", "u32", "u64", "u128", "usize", "f32", "f64",
+                "bool", "char", "str", "String", "Vec", "Box", "Option",
+                "Result", "Some", "None", "Ok", "Err", "Rc", "Arc", "RefCell",
+                "println", "print", "format", "vec", "panic", "assert",
+                "assert_eq"};
+            rust._line_comment = "//";
+            rust._block_comment_begin = "/*";
+            rust._block_comment_end = "*/";
+            rust._quotes = "\"'";
+            rust._raw_strings = raw::rust;
+            rust._char_literals = true;
+            rust._hash_attributes = true;
+            result.emplace_back(std::move(rust));
+
+            language d;
+            d._names = {"d", "dlang"};
+            d._keywords = {"abstract", "alias", "align", "asm", "assert",
+                "auto", "body", "bool", "break", "byte", "case", "cast",
+                "catch", "char", "class", "const", "continue", "dchar",
+                "debug", "default", "delegate", "delete", "do", "double",
+                "else", "enum", "export", "extern", "false", "final",
+                "finally", "float", "for", "foreach", "foreach_reverse",
+                "function", "goto", "if", "immutable", "import", "in",
+                "inout", "int", "interface", "invariant", "is", "lazy", "long",
+                "mixin", "module", "new", "nothrow", "null", "out",
+                "override", "package", "pragma", "private", "protected",
+                "public", "pure", "real", "ref", "return", "scope", "shared",
+                "short", "static", "struct", "super", "switch",
+                "synchronized", "template", "this", "throw", "true", "try",
+                "typeid", "typeof", "ubyte", "uint", "ulong", "union",
+                "unittest", "ushort", "version", "void", "wchar", "while",
+                "with"};
+            d._built_ins = {"string", "wstring", "dstring", "size_t",
+                "ptrdiff_t", "writeln", "writefln", "std"};
+            d._line_comment = "//";
+            d._block_comment_begin = "/*";
+            d._block_comment_end = "*/";
+            d._quotes = "\"'";
+            d._raw_quotes = "`";
+            d._raw_strings = raw::d;
+            d._char_literals = true;
+            result.emplace_back(std::move(d));
+
+            language js;
+            js._names = {"javascript", "js", "json", "coffeescript"};
+            js._keywords = {"async", "await", "break", "case", "catch",
+                "class", "const", "continue", "debugger", "default", "delete",
+                "do", "else", "export", "extends", "false", "finally", "for",
+                "function", "if", "import", "in", "instanceof", "let", "new",
+                "null", "of", "return", "super", "switch", "this", "throw",
+                "true", "try", "typeof", "undefined", "var", "void", "while",
+                "with", "yield"};
+            js._built_ins = {"Array", "Object", "String", "Number", "Boolean",
+                "Math", "JSON", "Promise", "Map", "Set", "console", "window",
+                "document", "eval", "parseInt", "parseFloat", "require",
+                "module", "exports"};
+            js._line_comment = "//";
+            js._block_comment_begin = "/*";
+            js._block_comment_end = "*/";
+            js._quotes = "\"'`";
+            result.emplace_back(std::move(js));
+
+            language html;
+            html._names = {"html", "xml", "xhtml", "svg"};
+            html._markup = true;
+            result.emplace_back(std::move(html));
+
+            for(language& l : result)
+            {
+                std::sort(l._keywords.begin(), l._keywords.end());
+                std::sort(l._built_ins.begin(), l._built_ins.end());
+            }
+
+            return result;
+        }();
+
+        for(const language& l : languages)
+        {
+            if(std::find(l._names.begin(), l._names.end(), name) !=
+                l._names.end())
+            {
+                return &l;
+            }
+        }
+
+        return nullptr;
+    }
+
+    // Highlights plain (unescaped) source code as HTML: text is escaped and
+    // tokens are wrapped in `<span class="...">`, using the class names of
+    // the site's stylesheet.
+    [[nodiscard]] inline std::string highlight(
+        const language& l, std::string_view code)
+    {
+        std::string out;
+        out.reserve(code.size() * 2);
+
+        if(l._markup)
+        {
+            impl::highlight_markup(code, out, find_language("javascript"));
+        }
+        else
+        {
+            impl::highlight_code(l, code, out);
+        }
+
+        return out;
+    }
+
+    namespace impl
+    {
+        inline void highlight_markup(std::string_view src, std::string& out,
+            const language* script_language)
+        {
+            std::size_t i = 0;
+            std::size_t plain_begin = 0;
+
+            const auto flush_plain = [&](std::size_t end)
+            {
+                append_code_text(
+                    out, src.substr(plain_begin, end - plain_begin));
+            };
+
+            const auto find_or_end = [&](std::string_view x, std::size_t from)
+            {
+                const std::size_t pos = src.find(x, from);
+                return pos == std::string_view::npos ? src.size()
+                                                     : pos + x.size();
+            };
+
+            while(i < src.size())
+            {
+                if(src[i] != '<')
+                {
+                    ++i;
+                    continue;
+                }
+
+                flush_plain(i);
+
+                if(src.substr(i, 4) == "<!--")
+                {
+                    const std::size_t end = find_or_end("-->", i + 4);
+                    append_span(out, css::comment, src.substr(i, end - i));
+                    i = plain_begin = end;
+                    continue;
+                }
+
+                if(src.substr(i, 2) == "<!" || src.substr(i, 2) == "<?")
+                {
+                    const std::size_t end = find_or_end(">", i);
+                    append_span(out, css::doctype, src.substr(i, end - i));
+                    i = plain_begin = end;
+                    continue;
+                }
+
+                // `<` or `</`, then the tag name.
+                const bool closing = i + 1 < src.size() && src[i + 1] == '/';
+                std::size_t j = i + (closing ? 2 : 1);
+
+                const std::size_t name_begin = j;
+                while(j < src.size() &&
+                      (is_ident(src[j]) || src[j] == '-' || src[j] == ':'))
+                {
+                    ++j;
+                }
+
+                if(j == name_begin)
+                {
+                    // A lone `<`: plain text.
+                    plain_begin = i;
+                    ++i;
+                    continue;
+                }
+
+                const std::string_view name =
+                    src.substr(name_begin, j - name_begin);
+
+                out += "<span class=\"tag\">";
+                append_code_text(out, src.substr(i, name_begin - i));
+                append_span(out, css::title, name);
+
+                // Attributes, up to the closing `>`.
+                while(j < src.size() && src[j] != '>')
+                {
+                    const char c = src[j];
+
+                    if(c == '"' || c == '\'')
+                    {
+                        const std::size_t end = find_or_end({&c, 1}, j + 1);
+                        append_span(out, css::value, src.substr(j, end - j));
+                        j = end;
+                    }
+                    else if(is_ident_start(c))
+                    {
+                        const std::size_t begin = j;
+                        while(j < src.size() && (is_ident(src[j]) ||
+                                                    src[j] == '-' ||
+                                                    src[j] == ':'))
+                        {
+                            ++j;
+                        }
+
+                        append_span(out, css::attribute,
+                            src.substr(begin, j - begin));
+                    }
+                    else
+                    {
+                        append_code_text(out, {&c, 1});
+                        ++j;
+                    }
+                }
+
+                if(j < src.size())
+                {
+                    out += "&gt;";
+                    ++j;
+                }
+
+                out += "</span>";
+                i = plain_begin = j;
+
+                if(script_language != nullptr && name == "script" && !closing)
+                {
+                    const std::size_t close = src.find("</script", i);
+                    const std::size_t end =
+                        close == std::string_view::npos ? src.size() : close;
+
+                    highlight_code(
+                        *script_language, src.substr(i, end - i), out);
+
+                    i = plain_begin = end;
+                }
+            }
+
+            flush_plain(src.size());
+        }
+    } // namespace impl
+
+    // A `<pre><code class="LANG">` block of rendered Markdown, with a
+    // supported language. `[_begin, _end)` is the HTML-escaped code.
+    struct code_block
+    {
+        std::size_t _begin;
+        std::size_t _end;
+        const language* _language;
+    };
+
+    // Finds the fenced code blocks of `html` whose language is supported.
+    // The `language-` class prefix is accepted too.
+    [[nodiscard]] inline std::vector<code_block> find_code_blocks(
+        std::string_view html)
+    {
+        constexpr std::string_view open{"<pre><code class=\""};
+        constexpr std::string_view close{"</code></pre>"};
+
+        std::vector<code_block> result;
+
+        for(std::size_t pos = html.find(open); pos != std::string_view::npos;
+            pos = html.find(open, pos))
+        {
+            const std::size_t class_begin = pos + open.size();
+            const std::size_t class_end = html.find('"', class_begin);
+            const std::size_t body_begin = html.find('>', class_begin);
+
+            if(class_end == std::string_view::npos ||
+                body_begin == std::string_view::npos)
+            {
+                break;
+            }
+
+            const std::size_t body_end = html.find(close, body_begin);
+            if(body_end == std::string_view::npos)
+            {
+                break;
+            }
+
+            std::string_view name =
+                html.substr(class_begin, class_end - class_begin);
+
+            name = name.substr(0, name.find(' '));
+            if(name.substr(0, 9) == "language-")
+            {
+                name.remove_prefix(9);
+            }
+
+            if(const language* l = find_language(name))
+            {
+                result.push_back(code_block{body_begin + 1, body_end, l});
+            }
+
+            pos = body_end + close.size();
+        }
+
+        return result;
+    }
+
+    // Replaces each block's code with `highlighted[i]`.
+    [[nodiscard]] inline std::string replace_code_blocks(std::string_view html,
+        const std::vector<code_block>& blocks,
+        const std::vector<std::string>& highlighted)
+    {
+        std::size_t size = html.size();
+        for(std::size_t i = 0; i < blocks.size(); ++i)
+        {
+            size += highlighted[i].size();
+        }
+
+        std::string result;
+        result.reserve(size);
+
+        std::size_t copied = 0;
+        for(std::size_t i = 0; i < blocks.size(); ++i)
+        {
+            result.append(html, copied, blocks[i]._begin - copied);
+            result += highlighted[i];
+            copied = blocks[i]._end;
+        }
+
+        result.append(html, copied);
+        return result;
+    }
+} // namespace vrdi
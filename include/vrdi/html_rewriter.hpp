@@ -0,0 +1,471 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <utility>
+
+namespace vrdi
+{
+    struct html_rewrite_options
+    {
+        // `src` and `href` values starting with `_rebase_from` are rewritten
+        // to start with `_rebase_to` instead.
+        std::string_view _rebase_from{"resources/"};
+        std::string_view _rebase_to{"/resources/"};
+
+        // Headings get an `id` derived from their text, unless they have one,
+        // and a trailing self-link with the `heading-anchor` class.
+        bool _heading_anchors{true};
+
+        // Images get `loading="lazy"` and `decoding="async"`, unless they
+        // specify otherwise.
+        bool _lazy_images{true};
+
+        // The excerpt ends after this many closing `</p>` tags.
+        std::size_t _excerpt_paragraphs{3};
+    };
+
+    struct rewritten_html
+    {
+        std::string _html;
+
+        // Offset in `_html` just past the closing `</p>` that ends the
+        // excerpt, or `npos` if the fragment is shorter than the excerpt.
+        std::size_t _excerpt_end{std::string::npos};
+    };
+
+    namespace impl
+    {
+        // Tokenizes a fragment once, copying it to a preallocated buffer in
+        // runs and splicing the rewrites in between.
+        class html_rewriter
+        {
+        private:
+            std::string_view _src;
+            const html_rewrite_options& _options;
+
+            rewritten_html _result;
+            std::size_t _i{0};
+            std::size_t _copied{0};
+            std::size_t _closed_paragraphs{0};
+
+            // The heading currently open, if any.
+            char _heading_level{'\0'};
+            std::size_t _heading_id_at{std::string::npos};
+            std::size_t _heading_text_begin{0};
+            std::string _heading_id;
+
+            std::unordered_set<std::string> _ids;
+
+            [[nodiscard]] static constexpr char lower(char c) noexcept
+            {
+                return c >= 'A' && c <= 'Z' ? char(c - 'A' + 'a') : c;
+            }
+
+            [[nodiscard]] static constexpr bool is_space(char c) noexcept
+            {
+                return c == ' ' || c == '\t' || c == '\n' || c == '\r' ||
+                       c == '\f';
+            }
+
+            [[nodiscard]] static constexpr bool is_alnum(char c) noexcept
+            {
+                return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+                       (c >= '0' && c <= '9');
+            }
+
+            [[nodiscard]] static constexpr bool is_name_char(char c) noexcept
+            {
+                return !is_space(c) && c != '>' && c != '/' && c != '=' &&
+                       c != '"' && c != '\'' && c != '<';
+            }
+
+            [[nodiscard]] static bool equals_lower(
+                std::string_view x, std::string_view lowercase) noexcept
+            {
+                if(x.size() != lowercase.size())
+                {
+                    return false;
+                }
+
+                for(std::size_t i = 0; i < x.size(); ++i)
+                {
+                    if(lower(x[i]) != lowercase[i])
+                    {
+                        return false;
+                    }
+                }
+
+                return true;
+            }
+
+            // Heading level ('1'-'6') of a tag name, or '\0'.
+            [[nodiscard]] static char heading_level(
+                std::string_view name) noexcept
+            {
+                return name.size() == 2 && lower(name[0]) == 'h' &&
+                               name[1] >= '1' && name[1] <= '6'
+                           ? name[1]
+                           : '\0';
+            }
+
+            std::string& out() noexcept
+            {
+                return _result._html;
+            }
+
+            // Copies the source up to `end`, unless already copied.
+            void flush(std::size_t end)
+            {
+                if(end > _copied)
+                {
+                    out().append(_src, _copied, end - _copied);
+                    _copied = end;
+                }
+            }
+
+            // Skips to just past `terminator`, or to the end of the source.
+            void skip_past(std::string_view terminator) noexcept
+            {
+                const std::size_t p = _src.find(terminator, _i);
+
+                _i = p == std::string_view::npos ? _src.size()
+                                                 : p + terminator.size();
+            }
+
+            [[nodiscard]] std::string_view read_name() noexcept
+            {
+                const std::size_t begin = _i;
+                while(_i < _src.size() && is_name_char(_src[_i]))
+                {
+                    ++_i;
+                }
+
+                return _src.substr(begin, _i - begin);
+            }
+
+            void skip_spaces() noexcept
+            {
+                while(_i < _src.size() && is_space(_src[_i]))
+                {
+                    ++_i;
+                }
+            }
+
+            // Lowercase ASCII letters and digits of the heading's text, with
+            // every other run of characters but UTF-8 collapsed into '-'.
+            [[nodiscard]] std::string slug(std::string_view text) const
+            {
+                std::string result;
+                bool in_tag = false;
+                bool in_entity = false;
+
+                for(const char c : text)
+                {
+                    if(in_tag || in_entity)
+                    {
+                        in_tag = in_tag && c != '>';
+                        in_entity = in_entity && c != ';';
+                        continue;
+                    }
+
+                    in_tag = c == '<';
+                    in_entity = c == '&';
+
+                    if(is_alnum(c) || static_cast<unsigned char>(c) >= 0x80)
+                    {
+                        result += lower(c);
+                    }
+                    else if(!result.empty() && result.back() != '-')
+                    {
+                        result += '-';
+                    }
+                }
+
+                while(!result.empty() && result.back() == '-')
+                {
+                    result.pop_back();
+                }
+
+                return result.empty() ? "section" : result;
+            }
+
+            [[nodiscard]] std::string unique_id(std::string id)
+            {
+                if(_ids.insert(id).second)
+                {
+                    return id;
+                }
+
+                for(std::size_t n = 2;; ++n)
+                {
+                    std::string candidate = id + '-' + std::to_string(n);
+                    if(_ids.insert(candidate).second)
+                    {
+                        return candidate;
+                    }
+                }
+            }
+
+            // Parses the attributes of the start tag `name`, up to and
+            // including its closing '>'.
+            void start_tag(std::string_view name)
+            {
+                const bool img = _options._lazy_images &&
+                                 equals_lower(name, "img");
+
+                const char level =
+                    _options._heading_anchors ? heading_level(name) : '\0';
+
+                bool has_id = false;
+                bool has_loading = false;
+                bool has_decoding = false;
+                std::string_view id;
+
+                while(true)
+                {
+                    skip_spaces();
+
+                    if(_i >= _src.size() || _src[_i] == '>' ||
+                        _src.compare(_i, 2, "/>") == 0)
+                    {
+                        break;
+                    }
+
+                    const std::string_view attribute = read_name();
+                    if(attribute.empty())
+                    {
+                        // Stray character, e.g. a lone '/'.
+                        ++_i;
+                        continue;
+                    }
+
+                    skip_spaces();
+                    if(_i >= _src.size() || _src[_i] != '=')
+                    {
+                        continue;
+                    }
+
+                    ++_i;
+                    skip_spaces();
+
+                    const char quote = _i < _src.size() ? _src[_i] : '\0';
+                    std::size_t value_begin = _i;
+                    std::size_t value_end;
+
+                    if(quote == '"' || quote == '\'')
+                    {
+                        ++value_begin;
+                        value_end = std::min(
+                            _src.find(quote, value_begin), _src.size());
+
+                        _i = std::min(value_end + 1, _src.size());
+                    }
+                    else
+                    {
+                        while(_i < _src.size() && !is_space(_src[_i]) &&
+                              _src[_i] != '>')
+                        {
+                            ++_i;
+                        }
+
+                        value_end = _i;
+                    }
+
+                    const std::string_view value =
+                        _src.substr(value_begin, value_end - value_begin);
+
+                    if((equals_lower(attribute, "src") ||
+                           equals_lower(attribute, "href")) &&
+                        !_options._rebase_from.empty() &&
+                        value.substr(0, _options._rebase_from.size()) ==
+                            _options._rebase_from)
+                    {
+                        flush(value_begin);
+                        out() += _options._rebase_to;
+                        _copied = value_begin + _options._rebase_from.size();
+                    }
+                    else if(equals_lower(attribute, "id"))
+                    {
+                        has_id = true;
+                        id = value;
+                    }
+                    else if(equals_lower(attribute, "loading"))
+                    {
+                        has_loading = true;
+                    }
+                    else if(equals_lower(attribute, "decoding"))
+                    {
+                        has_decoding = true;
+                    }
+                }
+
+                flush(_i);
+
+                if(img && !has_loading)
+                {
+                    out() += " loading=\"lazy\"";
+                }
+
+                if(img && !has_decoding)
+                {
+                    out() += " decoding=\"async\"";
+                }
+
+                skip_past(">");
+                flush(_i);
+
+                if(level != '\0')
+                {
+                    _heading_level = level;
+                    _heading_text_begin = out().size();
+
+                    if(has_id)
+                    {
+                        _heading_id = id;
+                        _ids.emplace(id);
+                        _heading_id_at = std::string::npos;
+                    }
+                    else
+                    {
+                        // Spliced in once the heading's text is known.
+                        _heading_id.clear();
+                        _heading_id_at = out().size() - 1;
+                    }
+                }
+            }
+
+            void end_heading()
+            {
+                if(_heading_id_at != std::string::npos)
+                {
+                    _heading_id =
+                        unique_id(slug(std::string_view{out()}.substr(
+                            _heading_text_begin)));
+
+                    out().insert(
+                        _heading_id_at, " id=\"" + _heading_id + "\"");
+                }
+
+                out() += "<a class=\"heading-anchor\" href=\"#";
+                out() += _heading_id;
+                out() += "\" aria-hidden=\"true\">#</a>";
+
+                _heading_level = '\0';
+            }
+
+            // Parses the end tag `name`, up to and including its '>'.
+            void end_tag(std::string_view name)
+            {
+                if(_heading_level != '\0' &&
+                    heading_level(name) == _heading_level)
+                {
+                    flush(_i - name.size() - 2);
+                    end_heading();
+                }
+
+                skip_past(">");
+
+                if(equals_lower(name, "p") &&
+                    ++_closed_paragraphs == _options._excerpt_paragraphs)
+                {
+                    flush(_i);
+                    _result._excerpt_end = out().size();
+                }
+            }
+
+            // Skips the raw text of `<script>` and `<style>` elements.
+            void skip_raw_text(std::string_view name)
+            {
+                while(_i < _src.size())
+                {
+                    skip_past("</");
+
+                    if(equals_lower(_src.substr(_i, name.size()), name))
+                    {
+                        _i -= 2;
+                        return;
+                    }
+                }
+            }
+
+            void markup()
+            {
+                if(_src.compare(_i, 4, "<!--") == 0)
+                {
+                    skip_past("-->");
+                    return;
+                }
+
+                const char next = _i + 1 < _src.size() ? _src[_i + 1] : '\0';
+
+                if(next == '!' || next == '?')
+                {
+                    skip_past(">");
+                    return;
+                }
+
+                if(next == '/')
+                {
+                    _i += 2;
+                    end_tag(read_name());
+                    return;
+                }
+
+                if(!is_alnum(next))
+                {
+                    // A literal '<'.
+                    ++_i;
+                    return;
+                }
+
+                ++_i;
+                const std::string_view name = read_name();
+                start_tag(name);
+
+                if(equals_lower(name, "script") || equals_lower(name, "style"))
+                {
+                    skip_raw_text(name);
+                }
+            }
+
+        public:
+            html_rewriter(
+                std::string_view src, const html_rewrite_options& options)
+                : _src{src}, _options{options}
+            {
+                // Rewrites only ever add a few bytes per tag.
+                out().reserve(src.size() + src.size() / 8 + 64);
+            }
+
+            [[nodiscard]] rewritten_html run() &&
+            {
+                while(_i < _src.size())
+                {
+                    _i = _src.find('<', _i);
+                    if(_i == std::string_view::npos)
+                    {
+                        _i = _src.size();
+                        break;
+                    }
+
+                    markup();
+                }
+
+                flush(_src.size());
+                return std::move(_result);
+            }
+        };
+    } // namespace impl
+
+    // Applies every rewrite of `options` to the HTML fragment `html` in a
+    // single pass, and finds where its excerpt ends.
+    [[nodiscard]] inline rewritten_html rewrite_html(
+        std::string_view html, const html_rewrite_options& options = {})
+    {
+        return impl::html_rewriter{html, options}.run();
+    }
+} // namespace vrdi
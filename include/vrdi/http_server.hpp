@@ -0,0 +1,678 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#endif
+
+namespace vrdi
+{
+    // Minimal static file server for local previews: HTTP/1.1 with
+    // keep-alive, `GET`/`HEAD` only.
+    //
+    // * Every worker thread runs its own `epoll` loop; the listening socket
+    //   is shared with `EPOLLEXCLUSIVE`, so each connection wakes one worker.
+    // * File bodies are sent with `sendfile`, without copying to user space.
+    // * Responses carry an `ETag` derived from size and modification time,
+    //   and `If-None-Match` is answered with `304 Not Modified`.
+    // * If the client accepts gzip and an up-to-date `<file>.gz` sidecar
+    //   exists, it is served instead, with `Content-Encoding: gzip`.
+    //
+    // Only available on Linux: elsewhere `run` returns `false` immediately.
+    class http_server
+    {
+    private:
+        std::filesystem::path _root;
+        std::uint16_t _port;
+        std::size_t _worker_count;
+
+        std::atomic<bool> _stopping{false};
+        int _listen_fd{-1};
+
+#ifdef __linux__
+        static constexpr std::size_t max_header_bytes{16 * 1024};
+
+        // Pipelined requests buffered while a response is being sent.
+        static constexpr std::size_t max_input_bytes{4 * max_header_bytes};
+
+        struct connection
+        {
+            int _fd;
+            std::string _in;
+            std::string _out;
+            std::size_t _out_sent{0};
+
+            int _file_fd{-1};
+            off_t _file_offset{0};
+            std::size_t _file_remaining{0};
+
+            bool _keep_alive{true};
+
+            explicit connection(int fd) noexcept : _fd{fd}
+            {
+            }
+
+            connection(const connection&) = delete;
+            connection& operator=(const connection&) = delete;
+
+            ~connection()
+            {
+                close_file();
+                close(_fd);
+            }
+
+            void close_file()
+            {
+                if(_file_fd >= 0)
+                {
+                    close(_file_fd);
+                    _file_fd = -1;
+                }
+            }
+
+            [[nodiscard]] bool writing() const noexcept
+            {
+                return _out_sent < _out.size() || _file_remaining > 0;
+            }
+        };
+
+        struct request
+        {
+            std::string _method;
+            std::string _target;
+            bool _http10{false};
+            std::unordered_map<std::string, std::string> _headers;
+
+            [[nodiscard]] std::string_view header(
+                const std::string& lowercase_name) const
+            {
+                const auto it = _headers.find(lowercase_name);
+                return it == _headers.end() ? std::string_view{}
+                                            : std::string_view{it->second};
+            }
+        };
+
+        [[nodiscard]] static std::string to_lower(std::string_view x)
+        {
+            std::string result{x};
+            for(char& c : result)
+            {
+                c = static_cast<char>(
+                    std::tolower(static_cast<unsigned char>(c)));
+            }
+
+            return result;
+        }
+
+        // Compares modification times to the nanosecond: a file rewritten
+        // within the same second must not look as old as its sidecar.
+        [[nodiscard]] static bool modified_not_before(
+            const struct stat& a, const struct stat& b) noexcept
+        {
+            return a.st_mtim.tv_sec != b.st_mtim.tv_sec
+                       ? a.st_mtim.tv_sec > b.st_mtim.tv_sec
+                       : a.st_mtim.tv_nsec >= b.st_mtim.tv_nsec;
+        }
+
+        [[nodiscard]] static std::string_view trim(std::string_view x)
+        {
+            while(!x.empty() && (x.front() == ' ' || x.front() == '\t'))
+            {
+                x.remove_prefix(1);
+            }
+
+            while(!x.empty() && (x.back() == ' ' || x.back() == '\t' ||
+                                    x.back() == '\r'))
+            {
+                x.remove_suffix(1);
+            }
+
+            return x;
+        }
+
+        [[nodiscard]] static bool parse_request(
+            std::string_view head, request& r)
+        {
+            std::size_t line_end = head.find("\r\n");
+            const std::string_view line = head.substr(0, line_end);
+
+            const std::size_t sp0 = line.find(' ');
+            const std::size_t sp1 = line.find(' ', sp0 + 1);
+            if(sp0 == std::string_view::npos || sp1 == std::string_view::npos)
+            {
+                return false;
+            }
+
+            r._method = std::string{line.substr(0, sp0)};
+            r._target = std::string{line.substr(sp0 + 1, sp1 - sp0 - 1)};
+            r._http10 = line.substr(sp1 + 1) == "HTTP/1.0";
+
+            while(line_end != std::string_view::npos)
+            {
+                const std::size_t begin = line_end + 2;
+                line_end = head.find("\r\n", begin);
+
+                const std::string_view h = head.substr(begin,
+                    line_end == std::string_view::npos ? std::string_view::npos
+                                                       : line_end - begin);
+
+                const std::size_t colon = h.find(':');
+                if(colon != std::string_view::npos)
+                {
+                    r._headers[to_lower(h.substr(0, colon))] =
+                        std::string{trim(h.substr(colon + 1))};
+                }
+            }
+
+            return true;
+        }
+
+        [[nodiscard]] static std::string url_decode(std::string_view x)
+        {
+            std::string result;
+            result.reserve(x.size());
+
+            for(std::size_t i = 0; i < x.size(); ++i)
+            {
+                if(x[i] == '%' && i + 2 < x.size() &&
+                    std::isxdigit(static_cast<unsigned char>(x[i + 1])) &&
+                    std::isxdigit(static_cast<unsigned char>(x[i + 2])))
+                {
+                    const std::string hex{x.substr(i + 1, 2)};
+                    result += static_cast<char>(std::stoi(hex, nullptr, 16));
+                    i += 2;
+                }
+                else
+                {
+                    result += x[i];
+                }
+            }
+
+            return result;
+        }
+
+        [[nodiscard]] static std::string_view content_type(
+            const std::filesystem::path& p)
+        {
+            static const std::unordered_map<std::string, std::string_view>
+                types{{".html", "text/html; charset=utf-8"},
+                    {".css", "text/css; charset=utf-8"},
+                    {".js", "application/javascript; charset=utf-8"},
+                    {".json", "application/json"},
+                    {".rss", "application/rss+xml; charset=utf-8"},
+                    {".atom", "application/atom+xml; charset=utf-8"},
+                    {".xml", "application/xml; charset=utf-8"},
+                    {".txt", "text/plain; charset=utf-8"},
+                    {".svg", "image/svg+xml"}, {".png", "image/png"},
+                    {".jpg", "image/jpeg"}, {".jpeg", "image/jpeg"},
+                    {".gif", "image/gif"}, {".ico", "image/x-icon"},
+                    {".woff", "font/woff"}, {".woff2", "font/woff2"},
+                    {".pdf", "application/pdf"}};
+
+            const auto it = types.find(to_lower(p.extension().string()));
+            return it == types.end() ? "application/octet-stream"
+                                     : it->second;
+        }
+
+        // Maps a request target to a regular file under `_root`, if any.
+        [[nodiscard]] bool resolve(
+            const std::string& target, std::filesystem::path& out) const
+        {
+            std::string path = url_decode(
+                std::string_view{target}.substr(0, target.find_first_of("?#")));
+
+            if(path.empty() || path[0] != '/' ||
+                path.find("..") != std::string::npos)
+            {
+                return false;
+            }
+
+            std::filesystem::path p = _root / path.substr(1);
+
+            std::error_code ec;
+            if(std::filesystem::is_directory(p, ec))
+            {
+                p /= "index.html";
+            }
+            else if(!std::filesystem::exists(p, ec) && !p.has_extension())
+            {
+                p += ".html";
+            }
+
+            if(!std::filesystem::is_regular_file(p, ec))
+            {
+                return false;
+            }
+
+            out = std::move(p);
+            return true;
+        }
+
+        static void set_simple_response(connection& c, std::string_view status,
+            std::string_view body, bool head_only)
+        {
+            c._out = "HTTP/1.1 ";
+            c._out += status;
+            c._out += "\r\nContent-Type: text/plain; charset=utf-8\r\n";
+            c._out += "Content-Length: " + std::to_string(body.size());
+            c._out += c._keep_alive ? "\r\nConnection: keep-alive\r\n\r\n"
+                                    : "\r\nConnection: close\r\n\r\n";
+
+            if(!head_only)
+            {
+                c._out += body;
+            }
+
+            c._out_sent = 0;
+        }
+
+        void prepare_response(connection& c, const request& r) const
+        {
+            const std::string_view connection_header = r.header("connection");
+            c._keep_alive =
+                r._http10 ? to_lower(connection_header) == "keep-alive"
+                          : to_lower(connection_header) != "close";
+
+            const bool head_only = r._method == "HEAD";
+            if(r._method != "GET" && !head_only)
+            {
+                set_simple_response(
+                    c, "405 Method Not Allowed", "method not allowed\n", false);
+                return;
+            }
+
+            std::filesystem::path p;
+            if(!resolve(r._target, p))
+            {
+                set_simple_response(
+                    c, "404 Not Found", "not found\n", head_only);
+                return;
+            }
+
+            const bool accepts_gzip =
+                r.header("accept-encoding").find("gzip") != std::string::npos;
+
+            struct stat st;
+            if(stat(p.c_str(), &st) != 0)
+            {
+                set_simple_response(
+                    c, "404 Not Found", "not found\n", head_only);
+                return;
+            }
+
+            std::filesystem::path served = p;
+            bool gzip = false;
+
+            if(accepts_gzip)
+            {
+                std::filesystem::path gz = p;
+                gz += ".gz";
+
+                struct stat gz_st;
+                if(stat(gz.c_str(), &gz_st) == 0 &&
+                    modified_not_before(gz_st, st))
+                {
+                    served = std::move(gz);
+                    st = gz_st;
+                    gzip = true;
+                }
+            }
+
+            std::string etag = "\"" + std::to_string(st.st_size) + "-" +
+                               std::to_string(st.st_mtim.tv_sec) + "." +
+                               std::to_string(st.st_mtim.tv_nsec) +
+                               (gzip ? "-gz\"" : "\"");
+
+            c._out = "HTTP/1.1 ";
+
+            if(r.header("if-none-match") == etag)
+            {
+                c._out += "304 Not Modified\r\n";
+            }
+            else
+            {
+                const int fd = open(served.c_str(), O_RDONLY | O_CLOEXEC);
+                if(fd < 0)
+                {
+                    set_simple_response(
+                        c, "404 Not Found", "not found\n", head_only);
+                    return;
+                }
+
+                c._out += "200 OK\r\n";
+                c._out += "Content-Length: " + std::to_string(st.st_size);
+                c._out += "\r\n";
+
+                if(head_only)
+                {
+                    close(fd);
+                }
+                else
+                {
+                    c._file_fd = fd;
+                    c._file_offset = 0;
+                    c._file_remaining = static_cast<std::size_t>(st.st_size);
+                }
+            }
+
+            c._out += "Content-Type: ";
+            c._out += content_type(p);
+            c._out += "\r\nETag: " + etag;
+            c._out += "\r\nCache-Control: no-cache\r\nVary: Accept-Encoding";
+
+            if(gzip)
+            {
+                c._out += "\r\nContent-Encoding: gzip";
+            }
+
+            c._out += c._keep_alive ? "\r\nConnection: keep-alive\r\n\r\n"
+                                    : "\r\nConnection: close\r\n\r\n";
+
+            c._out_sent = 0;
+        }
+
+        // Returns `false` if the connection must be closed.
+        [[nodiscard]] bool flush_output(connection& c) const
+        {
+            while(c._out_sent < c._out.size())
+            {
+                const ssize_t n = send(c._fd, c._out.data() + c._out_sent,
+                    c._out.size() - c._out_sent, MSG_NOSIGNAL);
+
+                if(n < 0)
+                {
+                    return errno == EAGAIN || errno == EWOULDBLOCK;
+                }
+
+                c._out_sent += static_cast<std::size_t>(n);
+            }
+
+            while(c._file_remaining > 0)
+            {
+                const ssize_t n = sendfile(c._fd, c._file_fd, &c._file_offset,
+                    c._file_remaining);
+
+                if(n < 0)
+                {
+                    return errno == EAGAIN || errno == EWOULDBLOCK;
+                }
+
+                if(n == 0)
+                {
+                    // File shrunk while sending: the response is broken.
+                    return false;
+                }
+
+                c._file_remaining -= static_cast<std::size_t>(n);
+            }
+
+            c.close_file();
+            return true;
+        }
+
+        // Handles as many complete requests as possible. Returns `false` if
+        // the connection must be closed.
+        [[nodiscard]] bool process(connection& c) const
+        {
+            while(!c.writing())
+            {
+                if(!c._out.empty() && !c._keep_alive)
+                {
+                    return false;
+                }
+
+                // Only look for the end of the headers within the limit.
+                const std::size_t end =
+                    std::string_view{c._in}.substr(0, max_header_bytes).find(
+                        "\r\n\r\n");
+
+                if(end == std::string::npos)
+                {
+                    return c._in.size() < max_header_bytes;
+                }
+
+                request r;
+                const bool ok = parse_request(
+                    std::string_view{c._in}.substr(0, end + 2), r);
+
+                c._in.erase(0, end + 4);
+
+                if(!ok)
+                {
+                    c._keep_alive = false;
+                    set_simple_response(
+                        c, "400 Bad Request", "bad request\n", false);
+                }
+                else
+                {
+                    prepare_response(c, r);
+                }
+
+                if(!flush_output(c))
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        // Returns `false` if the connection must be closed.
+        [[nodiscard]] bool on_readable(connection& c) const
+        {
+            char buf[8192];
+
+            while(true)
+            {
+                const ssize_t n = recv(c._fd, buf, sizeof(buf), 0);
+
+                if(n > 0)
+                {
+                    c._in.append(buf, static_cast<std::size_t>(n));
+
+                    // Handle requests as they arrive, so that a client
+                    // cannot grow the buffer without bound.
+                    if(!process(c) || c._in.size() > max_input_bytes)
+                    {
+                        return false;
+                    }
+
+                    continue;
+                }
+
+                if(n == 0)
+                {
+                    return false;
+                }
+
+                if(errno == EAGAIN || errno == EWOULDBLOCK)
+                {
+                    break;
+                }
+
+                return false;
+            }
+
+            return process(c);
+        }
+
+        void accept_all(int epfd,
+            std::unordered_map<int, std::unique_ptr<connection>>& conns) const
+        {
+            while(true)
+            {
+                const int fd = accept4(_listen_fd, nullptr, nullptr,
+                    SOCK_NONBLOCK | SOCK_CLOEXEC);
+
+                if(fd < 0)
+                {
+                    return;
+                }
+
+                const int one = 1;
+                setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+                epoll_event ev{};
+                ev.events = EPOLLIN | EPOLLOUT | EPOLLET | EPOLLRDHUP;
+                ev.data.fd = fd;
+                epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev);
+
+                conns[fd] = std::make_unique<connection>(fd);
+            }
+        }
+
+        void worker_loop() const
+        {
+            const int epfd = epoll_create1(EPOLL_CLOEXEC);
+
+            epoll_event listen_ev{};
+            listen_ev.events = EPOLLIN | EPOLLEXCLUSIVE;
+            listen_ev.data.fd = _listen_fd;
+            epoll_ctl(epfd, EPOLL_CTL_ADD, _listen_fd, &listen_ev);
+
+            std::unordered_map<int, std::unique_ptr<connection>> conns;
+            epoll_event events[64];
+
+            while(!_stopping)
+            {
+                const int n = epoll_wait(epfd, events, 64, 200);
+
+                for(int i = 0; i < n; ++i)
+                {
+                    const int fd = events[i].data.fd;
+
+                    if(fd == _listen_fd)
+                    {
+                        accept_all(epfd, conns);
+                        continue;
+                    }
+
+                    const auto it = conns.find(fd);
+                    if(it == conns.end())
+                    {
+                        continue;
+                    }
+
+                    connection& c = *it->second;
+                    bool alive = (events[i].events & EPOLLERR) == 0;
+
+                    if(alive && (events[i].events & EPOLLOUT) && c.writing())
+                    {
+                        alive = flush_output(c) && (c.writing() || process(c));
+                    }
+
+                    if(alive && (events[i].events & (EPOLLIN | EPOLLRDHUP)))
+                    {
+                        alive = on_readable(c);
+                    }
+
+                    if(!alive || (!c.writing() && !c._keep_alive &&
+                                     !c._out.empty()))
+                    {
+                        epoll_ctl(epfd, EPOLL_CTL_DEL, fd, nullptr);
+                        conns.erase(it);
+                    }
+                }
+            }
+
+            close(epfd);
+        }
+#endif
+
+    public:
+        http_server(std::filesystem::path root, std::uint16_t port,
+            std::size_t worker_count)
+            : _root{std::move(root)}, _port{port},
+              _worker_count{std::max(std::size_t(1), worker_count)}
+        {
+        }
+
+        ~http_server()
+        {
+#ifdef __linux__
+            if(_listen_fd >= 0)
+            {
+                close(_listen_fd);
+            }
+#endif
+        }
+
+        http_server(const http_server&) = delete;
+        http_server& operator=(const http_server&) = delete;
+
+        // Serves until `stop` is called. Returns `false` if the server could
+        // not be started.
+        [[nodiscard]] bool run()
+        {
+#ifdef __linux__
+            _listen_fd =
+                socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+
+            if(_listen_fd < 0)
+            {
+                return false;
+            }
+
+            const int one = 1;
+            setsockopt(_listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+            sockaddr_in addr{};
+            addr.sin_family = AF_INET;
+            addr.sin_port = htons(_port);
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+            if(bind(_listen_fd, reinterpret_cast<sockaddr*>(&addr),
+                   sizeof(addr)) != 0 ||
+                listen(_listen_fd, SOMAXCONN) != 0)
+            {
+                return false;
+            }
+
+            std::vector<std::thread> workers;
+            for(std::size_t i = 0; i < _worker_count; ++i)
+            {
+                workers.emplace_back([this] { worker_loop(); });
+            }
+
+            for(std::thread& t : workers)
+            {
+                t.join();
+            }
+
+            return true;
+#else
+            return false;
+#endif
+        }
+
+        void stop() noexcept
+        {
+            _stopping = true;
+        }
+    };
+} // namespace vrdi
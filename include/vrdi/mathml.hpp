@@ -0,0 +1,931 @@
+#pragma once
+
+#include "./escape.hpp"
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace vrdi
+{
+    // Bump whenever the generated MathML changes for the same TeX.
+    inline constexpr std::string_view mathml_version{"vrdi-mathml-1"};
+
+    namespace impl
+    {
+        struct tex_symbol
+        {
+            std::string_view _command;
+            std::string_view _element; // "mi" or "mo"
+            std::string_view _text;
+        };
+
+        // Commands that stand for a single character.
+        inline constexpr tex_symbol tex_symbols[]{
+            // Greek letters.
+            {"alpha", "mi", "α"}, {"beta", "mi", "β"}, {"gamma", "mi", "γ"},
+            {"delta", "mi", "δ"}, {"epsilon", "mi", "ϵ"},
+            {"varepsilon", "mi", "ε"}, {"zeta", "mi", "ζ"}, {"eta", "mi", "η"},
+            {"theta", "mi", "θ"}, {"vartheta", "mi", "ϑ"}, {"iota", "mi", "ι"},
+            {"kappa", "mi", "κ"}, {"lambda", "mi", "λ"}, {"mu", "mi", "μ"},
+            {"nu", "mi", "ν"}, {"xi", "mi", "ξ"}, {"pi", "mi", "π"},
+            {"rho", "mi", "ρ"}, {"sigma", "mi", "σ"}, {"tau", "mi", "τ"},
+            {"upsilon", "mi", "υ"}, {"phi", "mi", "ϕ"}, {"varphi", "mi", "φ"},
+            {"chi", "mi", "χ"}, {"psi", "mi", "ψ"}, {"omega", "mi", "ω"},
+
+            // Other identifiers.
+            {"infty", "mi", "∞"}, {"partial", "mi", "∂"}, {"nabla", "mi", "∇"},
+            {"emptyset", "mi", "∅"}, {"ell", "mi", "ℓ"},
+
+            // Operators and relations.
+            {"ldots", "mo", "…"}, {"dots", "mo", "…"}, {"cdots", "mo", "⋯"},
+            {"to", "mo", "→"}, {"rightarrow", "mo", "→"},
+            {"leftarrow", "mo", "←"}, {"gets", "mo", "←"},
+            {"Rightarrow", "mo", "⇒"}, {"Leftarrow", "mo", "⇐"},
+            {"leftrightarrow", "mo", "↔"}, {"Leftrightarrow", "mo", "⇔"},
+            {"implies", "mo", "⟹"}, {"iff", "mo", "⟺"},
+            {"mapsto", "mo", "↦"}, {"times", "mo", "×"}, {"cdot", "mo", "⋅"},
+            {"div", "mo", "÷"}, {"pm", "mo", "±"}, {"mp", "mo", "∓"},
+            {"le", "mo", "≤"}, {"leq", "mo", "≤"}, {"ge", "mo", "≥"},
+            {"geq", "mo", "≥"}, {"ne", "mo", "≠"}, {"neq", "mo", "≠"},
+            {"approx", "mo", "≈"}, {"equiv", "mo", "≡"}, {"sim", "mo", "∼"},
+            {"ll", "mo", "≪"}, {"gg", "mo", "≫"}, {"in", "mo", "∈"},
+            {"notin", "mo", "∉"}, {"subset", "mo", "⊂"},
+            {"subseteq", "mo", "⊆"}, {"cup", "mo", "∪"}, {"cap", "mo", "∩"},
+            {"wedge", "mo", "∧"}, {"land", "mo", "∧"}, {"vee", "mo", "∨"},
+            {"lor", "mo", "∨"}, {"neg", "mo", "¬"}, {"lnot", "mo", "¬"},
+            {"forall", "mo", "∀"}, {"exists", "mo", "∃"}, {"circ", "mo", "∘"},
+            {"mid", "mo", "∣"}, {"vert", "mo", "|"}, {"langle", "mo", "⟨"},
+            {"rangle", "mo", "⟩"}, {"lfloor", "mo", "⌊"},
+            {"rfloor", "mo", "⌋"}, {"lceil", "mo", "⌈"}, {"rceil", "mo", "⌉"},
+
+            // Large operators, with limits below and above.
+            {"sum", "mo", "∑"}, {"prod", "mo", "∏"}, {"bigcup", "mo", "⋃"},
+            {"bigcap", "mo", "⋂"},
+
+            // Large operators, with limits as scripts.
+            {"int", "mo", "∫"}, {"oint", "mo", "∮"}};
+
+        // Uppercase Greek letters are upright in TeX.
+        inline constexpr std::pair<std::string_view, std::string_view>
+            tex_upright_greek[]{{"Gamma", "Γ"}, {"Delta", "Δ"}, {"Theta", "Θ"},
+                {"Lambda", "Λ"}, {"Xi", "Ξ"}, {"Pi", "Π"}, {"Sigma", "Σ"},
+                {"Upsilon", "Υ"}, {"Phi", "Φ"}, {"Psi", "Ψ"},
+                {"Omega", "Ω"}};
+
+        // Upright function names. The first ones take limits below.
+        inline constexpr std::string_view tex_functions[]{"lim", "max", "min",
+            "sup", "inf", "det", "gcd", "sin", "cos", "tan", "cot", "sec",
+            "csc", "log", "ln", "lg", "exp", "arcsin", "arccos", "arctan",
+            "sinh", "cosh", "tanh", "deg", "dim", "ker", "arg"};
+
+        inline constexpr std::size_t tex_functions_with_limits{7};
+
+        inline constexpr std::pair<std::string_view, std::string_view>
+            tex_accents[]{{"hat", "^"}, {"widehat", "^"}, {"bar", "¯"},
+                {"overline", "‾"}, {"vec", "→"}, {"tilde", "~"},
+                {"widetilde", "~"}, {"dot", "˙"}, {"ddot", "¨"}};
+
+        inline constexpr std::pair<std::string_view, std::string_view>
+            tex_fonts[]{{"mathrm", "normal"}, {"mathbf", "bold"},
+                {"mathit", "italic"}, {"mathbb", "double-struck"},
+                {"mathcal", "script"}, {"mathsf", "sans-serif"},
+                {"mathtt", "monospace"}, {"operatorname", "normal"}};
+
+        [[nodiscard]] constexpr bool is_tex_letter(char c) noexcept
+        {
+            return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+        }
+
+        [[nodiscard]] constexpr bool is_tex_digit(char c) noexcept
+        {
+            return c >= '0' && c <= '9';
+        }
+
+        inline void append_math_element(std::string& out,
+            std::string_view tag, std::string_view text,
+            std::string_view attributes = {})
+        {
+            out += '<';
+            out += tag;
+            out += attributes;
+            out += '>';
+            escape_xml_to(out, text);
+            out += "</";
+            out += tag;
+            out += '>';
+        }
+
+        // Recursive-descent converter for the TeX subset used in posts.
+        // Anything outside of it makes the whole expression fail, so that it
+        // can be left to a client-side renderer.
+        class tex_parser
+        {
+        private:
+            std::string_view _src;
+            std::size_t _i{0};
+            bool _failed{false};
+
+            // An atom that was parsed, and whether scripts attached to it go
+            // below and above it instead of to its right.
+            struct atom
+            {
+                std::string _mathml;
+                bool _limits{false};
+            };
+
+            std::optional<atom> fail()
+            {
+                _failed = true;
+                return std::nullopt;
+            }
+
+            void skip_spaces() noexcept
+            {
+                while(_i < _src.size() &&
+                      (_src[_i] == ' ' || _src[_i] == '\n' ||
+                          _src[_i] == '\t' || _src[_i] == '\r'))
+                {
+                    ++_i;
+                }
+            }
+
+            [[nodiscard]] std::string_view command_name()
+            {
+                const std::size_t begin = _i;
+
+                if(_i < _src.size() && !is_tex_letter(_src[_i]))
+                {
+                    // Single-character command, e.g. `\{` or `\,`.
+                    return _src.substr(_i++, 1);
+                }
+
+                while(_i < _src.size() && is_tex_letter(_src[_i]))
+                {
+                    ++_i;
+                }
+
+                return _src.substr(begin, _i - begin);
+            }
+
+            // Verbatim contents of a `{...}` argument.
+            [[nodiscard]] std::optional<std::string_view> raw_group()
+            {
+                skip_spaces();
+
+                if(_i >= _src.size() || _src[_i] != '{')
+                {
+                    _failed = true;
+                    return std::nullopt;
+                }
+
+                const std::size_t begin = ++_i;
+                std::size_t depth = 1;
+
+                for(; _i < _src.size(); ++_i)
+                {
+                    if(_src[_i] == '{')
+                    {
+                        ++depth;
+                    }
+                    else if(_src[_i] == '}' && --depth == 0)
+                    {
+                        return _src.substr(begin, _i++ - begin);
+                    }
+                }
+
+                _failed = true;
+                return std::nullopt;
+            }
+
+            // A `{...}` group or a single atom, as for `\frac` or scripts.
+            [[nodiscard]] std::optional<std::string> argument()
+            {
+                skip_spaces();
+
+                if(_i >= _src.size())
+                {
+                    _failed = true;
+                    return std::nullopt;
+                }
+
+                // Arguments are single tokens: `\frac12` is one half.
+                if(is_tex_digit(_src[_i]))
+                {
+                    std::string out;
+                    append_math_element(out, "mn", _src.substr(_i++, 1));
+                    return out;
+                }
+
+                std::optional<atom> a = parse_atom();
+                if(!a)
+                {
+                    _failed = true;
+                    return std::nullopt;
+                }
+
+                return std::move(a->_mathml);
+            }
+
+            [[nodiscard]] std::optional<atom> delimiter()
+            {
+                skip_spaces();
+
+                if(_i >= _src.size())
+                {
+                    return fail();
+                }
+
+                if(_src[_i] == '.')
+                {
+                    ++_i;
+                    return atom{};
+                }
+
+                std::optional<atom> a = parse_atom();
+                if(!a || a->_mathml.compare(0, 3, "<mo") != 0)
+                {
+                    return fail();
+                }
+
+                return a;
+            }
+
+            [[nodiscard]] std::optional<atom> command()
+            {
+                const std::string_view name = command_name();
+                std::string out;
+
+                if(name.empty())
+                {
+                    return fail();
+                }
+
+                if(name == "|")
+                {
+                    append_math_element(out, "mo", "‖");
+                    return atom{std::move(out)};
+                }
+
+                if(name == "{" || name == "}" || name == "%" || name == "$" ||
+                    name == "#" || name == "&")
+                {
+                    append_math_element(out, "mo", name);
+                    return atom{std::move(out)};
+                }
+
+                if(name == "_")
+                {
+                    append_math_element(out, "mi", name);
+                    return atom{std::move(out)};
+                }
+
+                if(name == "," || name == ":" || name == ";" || name == " " ||
+                    name == "quad" || name == "qquad")
+                {
+                    const std::string_view width = name == ","   ? "0.167em"
+                                                   : name == ":" ? "0.222em"
+                                                   : name == ";" ? "0.278em"
+                                                   : name == " " ? "0.25em"
+                                                   : name == "quad"
+                                                       ? "1em"
+                                                       : "2em";
+
+                    out += "<mspace width=\"";
+                    out += width;
+                    out += "\"/>";
+                    return atom{std::move(out)};
+                }
+
+                if(name == "!")
+                {
+                    return atom{"<mspace width=\"-0.167em\"/>"};
+                }
+
+                for(const tex_symbol& s : tex_symbols)
+                {
+                    if(s._command == name)
+                    {
+                        append_math_element(out, s._element, s._text);
+
+                        const bool limits = name == "sum" || name == "prod" ||
+                                            name == "bigcup" ||
+                                            name == "bigcap";
+
+                        return atom{std::move(out), limits};
+                    }
+                }
+
+                for(const auto& [command, text] : tex_upright_greek)
+                {
+                    if(command == name)
+                    {
+                        append_math_element(
+                            out, "mi", text, " mathvariant=\"normal\"");
+
+                        return atom{std::move(out)};
+                    }
+                }
+
+                for(std::size_t f = 0; f < std::size(tex_functions); ++f)
+                {
+                    if(tex_functions[f] == name)
+                    {
+                        append_math_element(out, "mi", name);
+                        return atom{std::move(out),
+                            f < tex_functions_with_limits};
+                    }
+                }
+
+                if(name == "frac" || name == "dfrac" || name == "tfrac")
+                {
+                    const std::optional<std::string> num = argument();
+                    const std::optional<std::string> den = argument();
+
+                    if(!num || !den)
+                    {
+                        return fail();
+                    }
+
+                    return atom{"<mfrac>" + *num + *den + "</mfrac>"};
+                }
+
+                if(name == "sqrt")
+                {
+                    skip_spaces();
+
+                    std::optional<std::string> index;
+                    if(_i < _src.size() && _src[_i] == '[')
+                    {
+                        const std::size_t close = _src.find(']', _i);
+                        if(close == std::string_view::npos)
+                        {
+                            return fail();
+                        }
+
+                        index = tex_parser{_src.substr(_i + 1, close - _i - 1)}
+                                    .parse();
+
+                        if(!index)
+                        {
+                            return fail();
+                        }
+
+                        _i = close + 1;
+                    }
+
+                    const std::optional<std::string> radicand = argument();
+                    if(!radicand)
+                    {
+                        return fail();
+                    }
+
+                    if(index)
+                    {
+                        return atom{"<mroot><mrow>" + *radicand +
+                                    "</mrow><mrow>" + *index +
+                                    "</mrow></mroot>"};
+                    }
+
+                    return atom{"<msqrt>" + *radicand + "</msqrt>"};
+                }
+
+                if(name == "text" || name == "textrm" || name == "mbox")
+                {
+                    const std::optional<std::string_view> text = raw_group();
+                    if(!text)
+                    {
+                        return fail();
+                    }
+
+                    append_math_element(out, "mtext", *text);
+                    return atom{std::move(out)};
+                }
+
+                for(const auto& [command, variant] : tex_fonts)
+                {
+                    if(command != name)
+                    {
+                        continue;
+                    }
+
+                    const std::optional<std::string_view> text = raw_group();
+                    if(!text || text->empty())
+                    {
+                        return fail();
+                    }
+
+                    for(const char c : *text)
+                    {
+                        if(!is_tex_letter(c) && !is_tex_digit(c) && c != ' ')
+                        {
+                            return fail();
+                        }
+                    }
+
+                    append_math_element(out, "mi", *text,
+                        " mathvariant=\"" + std::string{variant} + "\"");
+
+                    return atom{std::move(out)};
+                }
+
+                for(const auto& [command, accent] : tex_accents)
+                {
+                    if(command != name)
+                    {
+                        continue;
+                    }
+
+                    const std::optional<std::string> base = argument();
+                    if(!base)
+                    {
+                        return fail();
+                    }
+
+                    out = "<mover accent=\"true\"><mrow>" + *base + "</mrow>";
+                    append_math_element(out, "mo", accent);
+                    out += "</mover>";
+
+                    return atom{std::move(out)};
+                }
+
+                if(name == "left" || name == "right" || name == "big" ||
+                    name == "Big" || name == "bigg" || name == "Bigg")
+                {
+                    return delimiter();
+                }
+
+                return fail();
+            }
+
+            // Parses one atom, without scripts.
+            [[nodiscard]] std::optional<atom> parse_atom()
+            {
+                const char c = _src[_i];
+                std::string out;
+
+                if(c == '{')
+                {
+                    ++_i;
+
+                    std::string inner = parse_sequence('}');
+                    if(_failed || _i >= _src.size())
+                    {
+                        return fail();
+                    }
+
+                    ++_i;
+                    return atom{"<mrow>" + inner + "</mrow>"};
+                }
+
+                if(c == '\\')
+                {
+                    ++_i;
+                    return command();
+                }
+
+                if(is_tex_letter(c))
+                {
+                    append_math_element(out, "mi", _src.substr(_i++, 1));
+                    return atom{std::move(out)};
+                }
+
+                if(is_tex_digit(c) || (c == '.' && _i + 1 < _src.size() &&
+                                          is_tex_digit(_src[_i + 1])))
+                {
+                    const std::size_t begin = _i++;
+                    while(_i < _src.size() &&
+                          (is_tex_digit(_src[_i]) ||
+                              (_src[_i] == '.' && _i + 1 < _src.size() &&
+                                  is_tex_digit(_src[_i + 1]))))
+                    {
+                        ++_i;
+                    }
+
+                    append_math_element(
+                        out, "mn", _src.substr(begin, _i - begin));
+                    return atom{std::move(out)};
+                }
+
+                if(c == '-')
+                {
+                    ++_i;
+                    append_math_element(out, "mo", "−");
+                    return atom{std::move(out)};
+                }
+
+                if(c == '*')
+                {
+                    ++_i;
+                    append_math_element(out, "mo", "∗");
+                    return atom{std::move(out)};
+                }
+
+                if(c == '~')
+                {
+                    ++_i;
+                    return atom{"<mspace width=\"0.333em\"/>"};
+                }
+
+                if(std::string_view{"+=<>,;:!?()[]|/."}.find(c) !=
+                    std::string_view::npos)
+                {
+                    append_math_element(out, "mo", _src.substr(_i++, 1));
+                    return atom{std::move(out)};
+                }
+
+                if(static_cast<unsigned char>(c) >= 0x80)
+                {
+                    // A non-ASCII character, e.g. `π` typed directly.
+                    const std::size_t begin = _i++;
+                    while(_i < _src.size() &&
+                          (static_cast<unsigned char>(_src[_i]) & 0xC0) == 0x80)
+                    {
+                        ++_i;
+                    }
+
+                    append_math_element(
+                        out, "mi", _src.substr(begin, _i - begin));
+                    return atom{std::move(out)};
+                }
+
+                // `&`, `#`, `}`, `^`, `_` without a base, ...
+                return fail();
+            }
+
+            // Attaches `_`, `^` and `'` scripts following `base`, if any.
+            [[nodiscard]] std::string with_scripts(atom base)
+            {
+                std::optional<std::string> sub;
+                std::optional<std::string> sup;
+
+                while(!_failed)
+                {
+                    skip_spaces();
+
+                    if(_i >= _src.size())
+                    {
+                        break;
+                    }
+
+                    const char c = _src[_i];
+
+                    if(c == '_' && !sub)
+                    {
+                        ++_i;
+                        sub = argument();
+                    }
+                    else if(c == '^' && !sup)
+                    {
+                        ++_i;
+
+                        const std::optional<std::string> x = argument();
+                        if(x)
+                        {
+                            sup = sup.value_or("") + *x;
+                        }
+                    }
+                    else if(c == '\'')
+                    {
+                        ++_i;
+                        sup = sup.value_or("") + "<mo>′</mo>";
+                    }
+                    else
+                    {
+                        break;
+                    }
+                }
+
+                if(_failed || (!sub && !sup))
+                {
+                    return std::move(base._mathml);
+                }
+
+                const std::string_view under = base._limits ? "under" : "sub";
+                const std::string_view over = base._limits ? "over" : "sup";
+
+                std::string tag{"m"};
+                if(sub && sup)
+                {
+                    tag += under;
+                    tag += over;
+                }
+                else
+                {
+                    tag += sub ? under : over;
+                }
+
+                std::string out = "<" + tag + ">" + base._mathml;
+
+                for(const std::optional<std::string>* script : {&sub, &sup})
+                {
+                    if(*script)
+                    {
+                        out += "<mrow>" + **script + "</mrow>";
+                    }
+                }
+
+                return out + "</" + tag + ">";
+            }
+
+            // Parses atoms until `terminator` or the end of the input.
+            [[nodiscard]] std::string parse_sequence(char terminator)
+            {
+                std::string out;
+
+                while(!_failed)
+                {
+                    skip_spaces();
+
+                    if(_i >= _src.size() || _src[_i] == terminator)
+                    {
+                        break;
+                    }
+
+                    std::optional<atom> a = parse_atom();
+                    if(!a)
+                    {
+                        break;
+                    }
+
+                    out += with_scripts(std::move(*a));
+                }
+
+                return out;
+            }
+
+        public:
+            explicit tex_parser(std::string_view src) noexcept : _src{src}
+            {
+            }
+
+            // Presentation MathML for the whole input, or `nullopt`.
+            [[nodiscard]] std::optional<std::string> parse()
+            {
+                std::string out = parse_sequence('\0');
+
+                if(_failed || _i != _src.size() || out.empty())
+                {
+                    return std::nullopt;
+                }
+
+                return out;
+            }
+        };
+    } // namespace impl
+
+    // Converts a TeX math expression (without delimiters) to a MathML
+    // `<math>` element, keeping the source as an annotation. Returns
+    // `nullopt` for anything outside of the supported subset.
+    [[nodiscard]] inline std::optional<std::string> tex_to_mathml(
+        std::string_view tex, bool display)
+    {
+        std::optional<std::string> body = impl::tex_parser{tex}.parse();
+        if(!body)
+        {
+            return std::nullopt;
+        }
+
+        std::string out{"<math xmlns=\"http://www.w3.org/1998/Math/MathML\""};
+        out += display ? " display=\"block\">" : ">";
+        out += "<semantics><mrow>";
+        out += *body;
+        out += "</mrow><annotation encoding=\"application/x-tex\">";
+        escape_xml_to(out, tex);
+        out += "</annotation></semantics></math>";
+
+        return out;
+    }
+
+    // Math that could not be converted is written in this form, which the
+    // MathJax runtime picks up.
+    [[nodiscard]] inline bool has_unconverted_math(std::string_view html)
+    {
+        return html.find("<span class=\"math ") != std::string_view::npos;
+    }
+
+    namespace impl
+    {
+        // End of the element starting at `i` (e.g. `<pre>`), if its contents
+        // must not be scanned for math.
+        [[nodiscard]] inline std::size_t skipped_element_end(
+            std::string_view html, std::size_t i)
+        {
+            for(const std::string_view name :
+                {"pre", "code", "script", "style", "math"})
+            {
+                if(html.substr(i + 1, name.size()) != name)
+                {
+                    continue;
+                }
+
+                const char after = i + 1 + name.size() < html.size()
+                                       ? html[i + 1 + name.size()]
+                                       : '\0';
+
+                if(after != '>' && after != ' ')
+                {
+                    continue;
+                }
+
+                const std::string closing = "</" + std::string{name} + ">";
+                const std::size_t end = html.find(closing, i);
+
+                return end == std::string_view::npos ? html.size()
+                                                     : end + closing.size();
+            }
+
+            return std::string_view::npos;
+        }
+
+        // Position of `closing` after `from` in the same run of text, i.e.
+        // before any tag.
+        [[nodiscard]] inline std::size_t find_in_text(std::string_view html,
+            std::string_view closing, std::size_t from)
+        {
+            const std::size_t end = html.find(closing, from);
+            const std::size_t tag = html.find('<', from);
+
+            return end < tag ? end : std::string_view::npos;
+        }
+
+        // Pandoc's rule for `$...$`: no space after the opening dollar, none
+        // before the closing one, and no digit right after it.
+        [[nodiscard]] inline std::size_t find_inline_dollar_end(
+            std::string_view html, std::size_t open)
+        {
+            if(open + 1 >= html.size() || html[open + 1] == ' ' ||
+                html[open + 1] == '\n')
+            {
+                return std::string_view::npos;
+            }
+
+            for(std::size_t i = open + 1; i < html.size(); ++i)
+            {
+                const char c = html[i];
+
+                if(c == '<' || (c == '\n' && i + 1 < html.size() &&
+                                   html[i + 1] == '\n'))
+                {
+                    break;
+                }
+
+                if(c == '\\')
+                {
+                    ++i;
+                }
+                else if(c == '$')
+                {
+                    const bool space_before =
+                        html[i - 1] == ' ' || html[i - 1] == '\n';
+
+                    const bool digit_after =
+                        i + 1 < html.size() && is_tex_digit(html[i + 1]);
+
+                    return space_before || digit_after ? std::string_view::npos
+                                                       : i;
+                }
+            }
+
+            return std::string_view::npos;
+        }
+    } // namespace impl
+
+    // Finds the math of rendered Markdown and replaces it with the result of
+    // `f(tex, display)`, which is MathML or an empty string if the expression
+    // is not supported. Recognizes `$...$`, `$$...$$` and pandoc's
+    // `<span class="math ...">` wrappers, outside of code. A `\[` or `\(` in
+    // the text is never math: it is what remains of an escaped bracket.
+    //
+    // Unsupported expressions are written as `<span class="math inline">`
+    // or `<span class="math display">` with `\(...\)` or `\[...\]`.
+    template <typename TF>
+    [[nodiscard]] std::string convert_math(std::string_view html, TF&& f)
+    {
+        constexpr std::string_view pandoc_inline{
+            "<span class=\"math inline\">\\("};
+        constexpr std::string_view pandoc_display{
+            "<span class=\"math display\">\\["};
+
+        std::string result;
+        std::size_t copied = 0;
+
+        // Replaces `[begin, end)` with the expression `escaped_tex`.
+        const auto replace = [&](std::size_t begin, std::size_t end,
+                                 std::string_view escaped_tex, bool display)
+        {
+            result.append(html, copied, begin - copied);
+            copied = end;
+
+            std::string mathml = f(unescape_html(escaped_tex), display);
+            if(!mathml.empty())
+            {
+                result += mathml;
+                return;
+            }
+
+            result += display ? pandoc_display : pandoc_inline;
+            result += escaped_tex;
+            result += display ? "\\]</span>" : "\\)</span>";
+        };
+
+        for(std::size_t i = 0; i < html.size();)
+        {
+            const char c = html[i];
+            const std::string_view rest = html.substr(i);
+
+            if(c == '<')
+            {
+                const bool is_inline = rest.substr(0, pandoc_inline.size()) ==
+                                       pandoc_inline;
+
+                const bool is_display =
+                    rest.substr(0, pandoc_display.size()) == pandoc_display;
+
+                if(is_inline || is_display)
+                {
+                    const std::size_t begin =
+                        i + (is_inline ? pandoc_inline : pandoc_display).size();
+                    const std::size_t end = html.find(
+                        is_inline ? "\\)</span>" : "\\]</span>", begin);
+
+                    if(end != std::string_view::npos)
+                    {
+                        replace(i, end + 9, html.substr(begin, end - begin),
+                            is_display);
+
+                        i = end + 9;
+                        continue;
+                    }
+                }
+
+                const std::size_t skipped = impl::skipped_element_end(html, i);
+                if(skipped != std::string_view::npos)
+                {
+                    i = skipped;
+                    continue;
+                }
+
+                const std::size_t tag_end = html.find('>', i);
+                i = tag_end == std::string_view::npos ? html.size()
+                                                      : tag_end + 1;
+                continue;
+            }
+
+            std::string_view closing;
+            std::size_t open_size = 2;
+            bool display = false;
+
+            if(rest.substr(0, 2) == "$$")
+            {
+                closing = "$$";
+                display = true;
+            }
+            else if(c == '\\')
+            {
+                // Escaped character, e.g. `\$`.
+                i += 2;
+                continue;
+            }
+            else if(c == '$')
+            {
+                const std::size_t end = impl::find_inline_dollar_end(html, i);
+
+                if(end != std::string_view::npos)
+                {
+                    replace(i, end + 1, html.substr(i + 1, end - i - 1), false);
+                    i = end + 1;
+                    continue;
+                }
+            }
+
+            if(!closing.empty())
+            {
+                const std::size_t end =
+                    impl::find_in_text(html, closing, i + open_size);
+
+                if(end != std::string_view::npos && end > i + open_size)
+                {
+                    replace(i, end + closing.size(),
+                        html.substr(i + open_size, end - i - open_size),
+                        display);
+
+                    i = end + closing.size();
+                    continue;
+                }
+            }
+
+            ++i;
+        }
+
+        if(copied == 0)
+        {
+            return std::string{html};
+        }
+
+        result.append(html, copied);
+        return result;
+    }
+} // namespace vrdi
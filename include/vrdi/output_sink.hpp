@@ -0,0 +1,364 @@
+#pragma once
+
+#include "./hash.hpp"
+#include "./profiler.hpp"
+#include "./thread_pool.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace vrdi
+{
+    // Asynchronous sink for generated files. Writes are collected into
+    // batches, and every full batch is written by a single pool task, so
+    // many small files do not cost one task each.
+    //
+    // * Parent directories are created natively, once per directory.
+    // * Every file is written to a temporary sibling and renamed into place,
+    //   so readers (e.g. a running web server) never observe partial files.
+    //   Failed writes remove their temporary file, are neither hashed nor
+    //   reported as changed, and are collected for `take_failures`.
+    //
+    // * Optionally, files whose new contents hash to the same value as the
+    //   existing file are left untouched, preserving their modification
+    //   time. Hashes are remembered in an index file between runs, so that
+    //   unchanged files do not even need to be read back.
+    //
+    // `flush` must be called before relying on the files being on disk.
+    class output_sink
+    {
+    private:
+        struct pending_write
+        {
+            std::filesystem::path _path;
+            std::string _contents;
+        };
+
+        static constexpr std::size_t max_batch_files{16};
+        static constexpr std::size_t max_batch_bytes{1024 * 1024};
+
+        task_group _writes;
+
+        std::mutex _batch_mtx;
+        std::vector<pending_write> _batch;
+        std::size_t _batch_bytes{0};
+
+        std::mutex _dirs_mtx;
+        std::unordered_set<std::string> _created_dirs;
+
+        std::atomic<std::uint64_t> _next_temp_id{0};
+
+        bool _skip_unchanged;
+        std::filesystem::path _index_path;
+
+        std::mutex _index_mtx;
+        std::unordered_map<std::string, std::uint64_t> _hashes;
+        std::vector<std::string> _changed;
+        std::vector<std::string> _failures;
+
+        profiler* _profiler{nullptr};
+
+        void load_index()
+        {
+            std::ifstream ifs{_index_path};
+
+            std::string line;
+            while(std::getline(ifs, line))
+            {
+                // Outputs with a damaged line are compared by contents.
+                const auto tab = line.find('\t');
+                if(tab == std::string::npos)
+                {
+                    continue;
+                }
+
+                const std::optional<std::uint64_t> hash =
+                    parse_hex(std::string_view{line}.substr(0, tab));
+
+                if(hash)
+                {
+                    _hashes[line.substr(tab + 1)] = *hash;
+                }
+            }
+        }
+
+        [[nodiscard]] bool is_unchanged(
+            const pending_write& w, std::uint64_t hash)
+        {
+            std::error_code ec;
+            const auto size = std::filesystem::file_size(w._path, ec);
+
+            if(ec || size != w._contents.size())
+            {
+                return false;
+            }
+
+            {
+                std::scoped_lock lock{_index_mtx};
+
+                const auto it = _hashes.find(w._path.string());
+                if(it != _hashes.end())
+                {
+                    return it->second == hash;
+                }
+            }
+
+            return hash_bytes(read_file(w._path)) == hash;
+        }
+
+        // Directories are only remembered once they were created.
+        [[nodiscard]] bool ensure_parent_directory(
+            const std::filesystem::path& p, std::error_code& ec)
+        {
+            const std::filesystem::path parent = p.parent_path();
+            if(parent.empty())
+            {
+                return true;
+            }
+
+            std::scoped_lock lock{_dirs_mtx};
+
+            if(_created_dirs.count(parent.string()) != 0)
+            {
+                return true;
+            }
+
+            std::filesystem::create_directories(parent, ec);
+            if(ec)
+            {
+                return false;
+            }
+
+            _created_dirs.insert(parent.string());
+            return true;
+        }
+
+        void fail(const pending_write& w, const std::string& reason)
+        {
+            std::scoped_lock lock{_index_mtx};
+            _failures.emplace_back(w._path.string() + ": " + reason);
+        }
+
+        void write_now(const pending_write& w)
+        {
+            // The path is only converted when it is recorded.
+            const bool profiled = _profiler != nullptr && _profiler->enabled();
+
+            std::string name;
+            if(profiled)
+            {
+                name = w._path.string();
+            }
+
+            const profile_scope scope{
+                profiled ? _profiler : nullptr, "write", name};
+
+            const std::uint64_t hash = hash_bytes(w._contents);
+
+            if(_skip_unchanged && is_unchanged(w, hash))
+            {
+                return;
+            }
+
+            std::error_code ec;
+            if(!ensure_parent_directory(w._path, ec))
+            {
+                fail(w, "could not create directory: " + ec.message());
+                return;
+            }
+
+            std::filesystem::path temp = w._path;
+            temp += ".tmp" + std::to_string(_next_temp_id++);
+
+            {
+                std::ofstream o{temp, std::ios::binary | std::ios::trunc};
+                o.write(w._contents.data(),
+                    static_cast<std::streamsize>(w._contents.size()));
+                o.close();
+
+                if(!o)
+                {
+                    std::filesystem::remove(temp, ec);
+                    fail(w, "could not write temporary file");
+                    return;
+                }
+            }
+
+            std::filesystem::rename(temp, w._path, ec);
+            if(ec)
+            {
+                fail(w, "could not rename temporary file: " + ec.message());
+
+                std::filesystem::remove(temp, ec);
+                return;
+            }
+
+            std::scoped_lock lock{_index_mtx};
+            _hashes[w._path.string()] = hash;
+            _changed.emplace_back(w._path.string());
+        }
+
+        void submit_batch(std::vector<pending_write>&& batch)
+        {
+            if(batch.empty())
+            {
+                return;
+            }
+
+            auto shared_batch =
+                std::make_shared<std::vector<pending_write>>(std::move(batch));
+
+            _writes.run(
+                [this, shared_batch]
+                {
+                    for(const pending_write& w : *shared_batch)
+                    {
+                        write_now(w);
+                    }
+                });
+        }
+
+        [[nodiscard]] std::vector<pending_write> take_batch()
+        {
+            std::vector<pending_write> result;
+            result.swap(_batch);
+            _batch_bytes = 0;
+
+            return result;
+        }
+
+    public:
+        // If `index_path` is not empty, hashes of written files are loaded
+        // from and saved to it.
+        explicit output_sink(thread_pool& pool, bool skip_unchanged,
+            std::filesystem::path index_path = {})
+            : _writes{pool}, _skip_unchanged{skip_unchanged},
+              _index_path{std::move(index_path)}
+        {
+            if(!_index_path.empty())
+            {
+                load_index();
+            }
+        }
+
+        ~output_sink()
+        {
+            flush();
+        }
+
+        output_sink(const output_sink&) = delete;
+        output_sink& operator=(const output_sink&) = delete;
+
+        // Records every file write as a "write" scope in `p`.
+        void profile_with(profiler& p) noexcept
+        {
+            _profiler = &p;
+        }
+
+        void write(std::filesystem::path path, std::string contents)
+        {
+            std::vector<pending_write> full_batch;
+
+            {
+                std::scoped_lock lock{_batch_mtx};
+
+                _batch_bytes += contents.size();
+                _batch.push_back(
+                    pending_write{std::move(path), std::move(contents)});
+
+                if(_batch.size() >= max_batch_files ||
+                    _batch_bytes >= max_batch_bytes)
+                {
+                    full_batch = take_batch();
+                }
+            }
+
+            submit_batch(std::move(full_batch));
+        }
+
+        // Submits any partial batch and waits until every write is done.
+        void flush()
+        {
+            {
+                std::vector<pending_write> batch;
+
+                {
+                    std::scoped_lock lock{_batch_mtx};
+                    batch = take_batch();
+                }
+
+                submit_batch(std::move(batch));
+            }
+
+            _writes.wait();
+        }
+
+        // Records a file written outside of the sink as changed.
+        void note_changed(const std::filesystem::path& path)
+        {
+            std::scoped_lock lock{_index_mtx};
+            _changed.emplace_back(path.string());
+        }
+
+        // Paths actually written since the last call, sorted. Only
+        // meaningful after `flush`.
+        [[nodiscard]] std::vector<std::string> take_changed_paths()
+        {
+            std::scoped_lock lock{_index_mtx};
+
+            std::vector<std::string> result;
+            result.swap(_changed);
+            std::sort(result.begin(), result.end());
+
+            return result;
+        }
+
+        // Writes that failed since the last call, as "path: reason". Only
+        // meaningful after `flush`.
+        [[nodiscard]] std::vector<std::string> take_failures()
+        {
+            std::scoped_lock lock{_index_mtx};
+
+            std::vector<std::string> result;
+            result.swap(_failures);
+
+            return result;
+        }
+
+        void save_index()
+        {
+            if(_index_path.empty())
+            {
+                return;
+            }
+
+            std::ostringstream oss;
+
+            {
+                std::scoped_lock lock{_index_mtx};
+
+                for(const auto& [path, hash] : _hashes)
+                {
+                    oss << to_hex(hash) << '\t' << path << '\n';
+                }
+            }
+
+            write_file_atomically(_index_path, oss.str());
+        }
+    };
+} // namespace vrdi
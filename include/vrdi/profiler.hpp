@@ -0,0 +1,313 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace vrdi
+{
+    // Records named, timed scopes on per-thread tracks. Disabled by default:
+    // a disabled profiler costs one relaxed atomic load per scope.
+    //
+    // Every thread appends to its own track without locking. Tracks must only
+    // be read (`write_chrome_trace`, `slowest`) or `clear`ed while no scope
+    // is open, e.g. between builds.
+    class profiler
+    {
+    public:
+        using clock = std::chrono::steady_clock;
+
+        struct event
+        {
+            std::string_view _category;
+            std::string _name;
+            std::int64_t _begin_us;
+            std::int64_t _duration_us;
+        };
+
+        // Total time spent in the scopes with the same category and name.
+        struct summary_row
+        {
+            std::string_view _category;
+            std::string _name;
+            std::size_t _count;
+            std::int64_t _total_us;
+            std::int64_t _max_us;
+        };
+
+    private:
+        struct track
+        {
+            std::uint32_t _tid;
+            std::string _name;
+            std::vector<event> _events;
+        };
+
+        std::atomic<bool> _enabled{false};
+        clock::time_point _origin{clock::now()};
+
+        std::mutex _tracks_mtx;
+        std::vector<std::unique_ptr<track>> _tracks;
+
+        static inline thread_local const profiler* tl_profiler{nullptr};
+        static inline thread_local track* tl_track{nullptr};
+
+        [[nodiscard]] track& current_track()
+        {
+            if(tl_profiler == this)
+            {
+                return *tl_track;
+            }
+
+            std::scoped_lock lock{_tracks_mtx};
+
+            auto& t = _tracks.emplace_back(std::make_unique<track>());
+            t->_tid = static_cast<std::uint32_t>(_tracks.size());
+            t->_name = "thread " + std::to_string(t->_tid);
+
+            tl_profiler = this;
+            tl_track = t.get();
+
+            return *t;
+        }
+
+        [[nodiscard]] std::int64_t to_us(clock::time_point t) const noexcept
+        {
+            return std::chrono::duration_cast<std::chrono::microseconds>(
+                t - _origin)
+                .count();
+        }
+
+        static void append_json_string(std::string& out, std::string_view x)
+        {
+            out += '"';
+
+            for(const char c : x)
+            {
+                if(c == '"' || c == '\\')
+                {
+                    out += '\\';
+                    out += c;
+                }
+                else if(static_cast<unsigned char>(c) < 0x20)
+                {
+                    char buf[8];
+                    std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+                    out += buf;
+                }
+                else
+                {
+                    out += c;
+                }
+            }
+
+            out += '"';
+        }
+
+    public:
+        profiler() = default;
+
+        profiler(const profiler&) = delete;
+        profiler& operator=(const profiler&) = delete;
+
+        void enable() noexcept
+        {
+            _enabled.store(true, std::memory_order_relaxed);
+        }
+
+        [[nodiscard]] bool enabled() const noexcept
+        {
+            return _enabled.load(std::memory_order_relaxed);
+        }
+
+        // Names the calling thread's track in the timeline.
+        void name_current_thread(std::string name)
+        {
+            track& t = current_track();
+
+            std::scoped_lock lock{_tracks_mtx};
+            t._name = std::move(name);
+        }
+
+        void record(std::string_view category, std::string name,
+            clock::time_point begin, clock::time_point end)
+        {
+            const std::int64_t begin_us = to_us(begin);
+
+            current_track()._events.push_back(event{category, std::move(name),
+                begin_us, to_us(end) - begin_us});
+        }
+
+        // Drops all events, keeping tracks and their names.
+        void clear()
+        {
+            std::scoped_lock lock{_tracks_mtx};
+
+            for(auto& t : _tracks)
+            {
+                t->_events.clear();
+            }
+
+            _origin = clock::now();
+        }
+
+        // Writes every event as a "complete" event of the Chrome trace-event
+        // format, loadable in `chrome://tracing` or Perfetto. Returns `false`
+        // if the file could not be written.
+        [[nodiscard]] bool write_chrome_trace(const std::string& path)
+        {
+            std::scoped_lock lock{_tracks_mtx};
+
+            std::string out{"{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n"};
+            bool first = true;
+
+            const auto separator = [&]
+            {
+                if(!first)
+                {
+                    out += ",\n";
+                }
+
+                first = false;
+            };
+
+            for(const auto& t : _tracks)
+            {
+                const std::string tid = std::to_string(t->_tid);
+
+                separator();
+                out += "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,";
+                out += "\"tid\":" + tid + ",\"args\":{\"name\":";
+                append_json_string(out, t->_name);
+                out += "}}";
+
+                for(const event& e : t->_events)
+                {
+                    separator();
+                    out += "{\"ph\":\"X\",\"name\":";
+                    append_json_string(out, e._name);
+                    out += ",\"cat\":";
+                    append_json_string(out, e._category);
+                    out += ",\"pid\":1,\"tid\":" + tid;
+                    out += ",\"ts\":" + std::to_string(e._begin_us);
+                    out += ",\"dur\":" + std::to_string(e._duration_us) + "}";
+                }
+            }
+
+            out += "\n]}\n";
+
+            std::ofstream ofs{path, std::ios::binary | std::ios::trunc};
+            ofs.write(out.data(), static_cast<std::streamsize>(out.size()));
+
+            return static_cast<bool>(ofs);
+        }
+
+        // The `n` most expensive category/name pairs by total time, skipping
+        // `excluded_category` (e.g. whole build phases).
+        [[nodiscard]] std::vector<summary_row> slowest(
+            std::size_t n, std::string_view excluded_category = {})
+        {
+            std::map<std::pair<std::string_view, std::string_view>,
+                summary_row>
+                rows;
+
+            {
+                std::scoped_lock lock{_tracks_mtx};
+
+                for(const auto& t : _tracks)
+                {
+                    for(const event& e : t->_events)
+                    {
+                        if(e._category == excluded_category)
+                        {
+                            continue;
+                        }
+
+                        auto [it, inserted] =
+                            rows.try_emplace({e._category, e._name});
+
+                        summary_row& r = it->second;
+                        if(inserted)
+                        {
+                            r = summary_row{e._category, e._name, 0, 0, 0};
+                        }
+
+                        ++r._count;
+                        r._total_us += e._duration_us;
+                        r._max_us = std::max(r._max_us, e._duration_us);
+                    }
+                }
+            }
+
+            std::vector<summary_row> result;
+            result.reserve(rows.size());
+
+            for(auto& [key, r] : rows)
+            {
+                result.emplace_back(std::move(r));
+            }
+
+            std::sort(result.begin(), result.end(),
+                [](const summary_row& a, const summary_row& b)
+                { return a._total_us > b._total_us; });
+
+            result.resize(std::min(n, result.size()));
+            return result;
+        }
+    };
+
+    // Records the time between its construction and destruction, if the
+    // profiler is enabled. `category` must outlive the profiler, e.g. a
+    // string literal; `name` is copied only when recording.
+    class profile_scope
+    {
+    private:
+        profiler* _profiler;
+        std::string_view _category;
+        std::string _name;
+        profiler::clock::time_point _begin;
+
+    public:
+        // A null `p` records nothing.
+        profile_scope(
+            profiler* p, std::string_view category, std::string_view name)
+            : _profiler{p != nullptr && p->enabled() ? p : nullptr}
+        {
+            if(_profiler != nullptr)
+            {
+                _category = category;
+                _name = name;
+                _begin = profiler::clock::now();
+            }
+        }
+
+        profile_scope(
+            profiler& p, std::string_view category, std::string_view name)
+            : profile_scope{&p, category, name}
+        {
+        }
+
+        ~profile_scope()
+        {
+            if(_profiler != nullptr)
+            {
+                _profiler->record(_category, std::move(_name), _begin,
+                    profiler::clock::now());
+            }
+        }
+
+        profile_scope(const profile_scope&) = delete;
+        profile_scope& operator=(const profile_scope&) = delete;
+    };
+} // namespace vrdi
@@ -0,0 +1,310 @@
+#pragma once
+
+#include "./thread_pool.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace vrdi
+{
+    namespace impl
+    {
+        [[nodiscard]] constexpr bool is_token_char(char c) noexcept
+        {
+            return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+                   (c >= '0' && c <= '9');
+        }
+
+        [[nodiscard]] inline bool ends_with(
+            std::string_view x, std::string_view suffix) noexcept
+        {
+            return x.size() >= suffix.size() &&
+                   x.substr(x.size() - suffix.size()) == suffix;
+        }
+    } // namespace impl
+
+    // Light suffix-stripping stemmer for English. At most one rule applies,
+    // and only if at least three characters remain.
+    //
+    // Must be kept in sync with `stem` in `resources/js/search.js`.
+    [[nodiscard]] inline std::string stem(std::string word)
+    {
+        static const std::pair<std::string_view, std::string_view> rules[]{
+            {"ations", "ate"}, {"ation", "ate"}, {"ies", "y"}, {"ing", ""},
+            {"ed", ""}, {"ly", ""}, {"es", ""}, {"s", ""}};
+
+        for(const auto& [suffix, replacement] : rules)
+        {
+            if(!impl::ends_with(word, suffix))
+            {
+                continue;
+            }
+
+            if(suffix == "s" && impl::ends_with(word, "ss"))
+            {
+                break;
+            }
+
+            const std::size_t stem_size = word.size() - suffix.size();
+            if(stem_size + replacement.size() >= 3)
+            {
+                word.resize(stem_size);
+                word += replacement;
+            }
+
+            break;
+        }
+
+        return word;
+    }
+
+    // Calls `f(term)` for every stemmed, lowercase term in `text`, in order.
+    // Markup between `<` and `>` is skipped, and so are the contents of
+    // `<script>` and `<style>` elements.
+    //
+    // Must be kept in sync with `countTerms` in `resources/js/search.js`.
+    template <typename TF>
+    void for_each_term(std::string_view text, TF&& f)
+    {
+        constexpr std::size_t max_token_size{32};
+
+        std::string token;
+
+        const auto emit = [&]
+        {
+            if(token.size() >= 2 && token.size() <= max_token_size)
+            {
+                f(stem(std::move(token)));
+            }
+
+            token.clear();
+        };
+
+        for(std::size_t i = 0; i < text.size(); ++i)
+        {
+            const char c = text[i];
+
+            if(c == '<')
+            {
+                emit();
+
+                std::string_view closing = ">";
+
+                if(text.substr(i, 7) == "<script")
+                {
+                    closing = "</script>";
+                }
+                else if(text.substr(i, 6) == "<style")
+                {
+                    closing = "</style>";
+                }
+
+                const std::size_t end = text.find(closing, i);
+                if(end == std::string_view::npos)
+                {
+                    return;
+                }
+
+                i = end + closing.size() - 1;
+            }
+            else if(c == '&')
+            {
+                // Entities separate tokens: skip to the terminating `;`.
+                emit();
+
+                const std::size_t end = text.find(';', i);
+                if(end != std::string_view::npos && end - i <= 8)
+                {
+                    i = end;
+                }
+            }
+            else if(impl::is_token_char(c))
+            {
+                token += (c >= 'A' && c <= 'Z') ? char(c - 'A' + 'a') : c;
+            }
+            else
+            {
+                emit();
+            }
+        }
+
+        emit();
+    }
+
+    // Inverted index with positional postings, built in parallel.
+    //
+    // Documents are tokenized independently, one pool task each, and merged
+    // in document order by `encode`. Binary layout (all integers unsigned
+    // LEB128 varints, strings prefixed by their byte length):
+    //
+    //     "VRSI" version
+    //     doc_count  { url title }*
+    //     term_count { term doc_count { doc_delta pos_count pos_delta* }* }*
+    //
+    // Terms are sorted; document IDs and positions are delta-encoded.
+    class search_index
+    {
+    private:
+        static constexpr std::uint32_t format_version{1};
+
+        struct document
+        {
+            std::string _url;
+            std::string _title;
+
+            // Sorted by term: positions are increasing.
+            std::vector<std::pair<std::string, std::vector<std::uint32_t>>>
+                _terms;
+        };
+
+        task_group _todo;
+
+        std::mutex _mtx;
+        std::vector<document> _documents;
+
+        static void put_varint(std::string& out, std::uint64_t x)
+        {
+            while(x >= 0x80)
+            {
+                out += static_cast<char>((x & 0x7F) | 0x80);
+                x >>= 7;
+            }
+
+            out += static_cast<char>(x);
+        }
+
+        static void put_string(std::string& out, std::string_view x)
+        {
+            put_varint(out, x.size());
+            out += x;
+        }
+
+        [[nodiscard]] static document tokenize(std::string url,
+            std::string title, const std::vector<std::string>& fields)
+        {
+            std::unordered_map<std::string, std::vector<std::uint32_t>> terms;
+            std::uint32_t position = 0;
+
+            const auto add = [&](std::string&& term)
+            { terms[std::move(term)].emplace_back(position++); };
+
+            // Title terms come first, at positions `[0, title term count)`.
+            for_each_term(title, add);
+            ++position;
+
+            for(const std::string& field : fields)
+            {
+                for_each_term(field, add);
+
+                // Phrases never match across fields.
+                ++position;
+            }
+
+            document result{std::move(url), std::move(title), {}};
+            result._terms.reserve(terms.size());
+
+            for(auto& [term, positions] : terms)
+            {
+                result._terms.emplace_back(term, std::move(positions));
+            }
+
+            std::sort(result._terms.begin(), result._terms.end(),
+                [](const auto& a, const auto& b) { return a.first < b.first; });
+
+            return result;
+        }
+
+    public:
+        explicit search_index(thread_pool& pool) : _todo{pool}
+        {
+        }
+
+        // Tokenizes the title and every field (plain text or HTML) in the
+        // background. The document's ID is its position in the final index,
+        // which depends only on the `url`s.
+        void add(std::string url, std::string title,
+            std::vector<std::string> fields)
+        {
+            _todo.run(
+                [this, url = std::move(url), title = std::move(title),
+                    fields = std::move(fields)]() mutable
+                {
+                    document d =
+                        tokenize(std::move(url), std::move(title), fields);
+
+                    std::scoped_lock lock{_mtx};
+                    _documents.emplace_back(std::move(d));
+                });
+        }
+
+        // Waits for all pending documents and returns the binary index.
+        [[nodiscard]] std::string encode()
+        {
+            _todo.wait();
+
+            std::scoped_lock lock{_mtx};
+
+            // Deterministic document order, regardless of task scheduling.
+            std::sort(_documents.begin(), _documents.end(),
+                [](const document& a, const document& b)
+                { return a._url < b._url; });
+
+            // Term -> (document ID, positions) postings, in document order.
+            using posting =
+                std::pair<std::uint32_t, const std::vector<std::uint32_t>*>;
+
+            std::map<std::string_view, std::vector<posting>> postings;
+
+            for(std::uint32_t id = 0; id < _documents.size(); ++id)
+            {
+                for(const auto& [term, positions] : _documents[id]._terms)
+                {
+                    postings[term].emplace_back(id, &positions);
+                }
+            }
+
+            std::string out{"VRSI"};
+            put_varint(out, format_version);
+
+            put_varint(out, _documents.size());
+            for(const document& d : _documents)
+            {
+                put_string(out, d._url);
+                put_string(out, d._title);
+            }
+
+            put_varint(out, postings.size());
+            for(const auto& [term, list] : postings)
+            {
+                put_string(out, term);
+                put_varint(out, list.size());
+
+                std::uint32_t previous_id = 0;
+                for(const auto& [id, positions] : list)
+                {
+                    put_varint(out, id - previous_id);
+                    previous_id = id;
+
+                    put_varint(out, positions->size());
+
+                    std::uint32_t previous_position = 0;
+                    for(const std::uint32_t p : *positions)
+                    {
+                        put_varint(out, p - previous_position);
+                        previous_position = p;
+                    }
+                }
+            }
+
+            return out;
+        }
+    };
+} // namespace vrdi
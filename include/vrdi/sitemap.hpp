@@ -0,0 +1,271 @@
+#pragma once
+
+#include "./escape.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+namespace vrdi
+{
+    // Modification time of `p` as Unix time, or zero if it does not exist.
+    [[nodiscard]] inline std::time_t last_write_unix_time(
+        const std::filesystem::path& p)
+    {
+        using namespace std::chrono;
+        using file_clock = std::filesystem::file_time_type::clock;
+
+        std::error_code ec;
+        const auto t = std::filesystem::last_write_time(p, ec);
+
+        if(ec)
+        {
+            return 0;
+        }
+
+        return system_clock::to_time_t(time_point_cast<system_clock::duration>(
+            t - file_clock::now() + system_clock::now()));
+    }
+
+    namespace impl
+    {
+        // Compares two files in fixed-size chunks.
+        [[nodiscard]] inline bool files_equal(
+            const std::filesystem::path& a, const std::filesystem::path& b)
+        {
+            std::error_code ec;
+            if(std::filesystem::file_size(a, ec) !=
+                std::filesystem::file_size(b, ec))
+            {
+                return false;
+            }
+
+            std::ifstream ia{a, std::ios::binary};
+            std::ifstream ib{b, std::ios::binary};
+
+            char ba[64 * 1024];
+            char bb[64 * 1024];
+
+            while(ia && ib)
+            {
+                ia.read(ba, sizeof(ba));
+                ib.read(bb, sizeof(bb));
+
+                if(ia.gcount() != ib.gcount() ||
+                    !std::equal(ba, ba + ia.gcount(), bb))
+                {
+                    return false;
+                }
+            }
+
+            return !ec;
+        }
+
+        inline void append_w3c_date(std::string& out, std::time_t t)
+        {
+            std::tm tm{};
+            gmtime_r(&t, &tm);
+
+            char buf[16];
+            std::strftime(buf, sizeof(buf), "%Y-%m-%d", &tm);
+            out += buf;
+        }
+    } // namespace impl
+
+    // Streams a sitemap to disk, one URL at a time: only the current line is
+    // held in memory.
+    //
+    // Beyond 50,000 URLs (or ~50MB) per file, URLs are split into
+    // `sitemap-N.xml` files and `sitemap.xml` becomes a sitemap index, as the
+    // protocol requires. Files are written to temporaries and only replace
+    // the existing ones if their contents differ.
+    class sitemap_writer
+    {
+    private:
+        static constexpr std::size_t max_urls_per_file{50000};
+        static constexpr std::size_t max_bytes_per_file{49 * 1024 * 1024};
+
+        struct part
+        {
+            std::filesystem::path _temp;
+            std::time_t _lastmod{0};
+        };
+
+        std::filesystem::path _dir;
+        std::string _base_url;
+
+        std::vector<part> _parts;
+        std::ofstream _out;
+        std::size_t _urls_in_part{0};
+        std::size_t _bytes_in_part{0};
+
+        std::string _line;
+
+        static constexpr std::string_view urlset_begin{
+            "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+            "<urlset xmlns=\"http://www.sitemaps.org/schemas/sitemap/0.9\">\n"};
+
+        static constexpr std::string_view urlset_end{"</urlset>\n"};
+
+        [[nodiscard]] std::filesystem::path part_path(std::size_t i) const
+        {
+            return _dir / ("sitemap-" + std::to_string(i + 1) + ".xml");
+        }
+
+        void close_part()
+        {
+            if(_out.is_open())
+            {
+                _out << urlset_end;
+                _out.close();
+            }
+        }
+
+        void open_part()
+        {
+            close_part();
+
+            part& p = _parts.emplace_back();
+            p._temp = part_path(_parts.size() - 1);
+            p._temp += ".tmp";
+
+            _out.open(p._temp, std::ios::binary | std::ios::trunc);
+            _out << urlset_begin;
+
+            _urls_in_part = 0;
+            _bytes_in_part = urlset_begin.size() + urlset_end.size();
+        }
+
+        // Moves `temp` over `target` unless they are equal. Returns `true` if
+        // `target` changed.
+        static bool replace_if_changed(const std::filesystem::path& temp,
+            const std::filesystem::path& target)
+        {
+            std::error_code ec;
+
+            if(impl::files_equal(temp, target))
+            {
+                std::filesystem::remove(temp, ec);
+                return false;
+            }
+
+            std::filesystem::rename(temp, target, ec);
+            return true;
+        }
+
+    public:
+        // `base_url` is the public URL of `dir`, ending with a slash.
+        sitemap_writer(std::filesystem::path dir, std::string base_url)
+            : _dir{std::move(dir)}, _base_url{std::move(base_url)}
+        {
+        }
+
+        // `loc` must be an absolute URL. A zero `lastmod` is omitted.
+        void add(std::string_view loc, std::time_t lastmod)
+        {
+            _line = "<url><loc>";
+            escape_xml_to(_line, loc);
+            _line += "</loc>";
+
+            if(lastmod != 0)
+            {
+                _line += "<lastmod>";
+                impl::append_w3c_date(_line, lastmod);
+                _line += "</lastmod>";
+            }
+
+            _line += "</url>\n";
+
+            if(_parts.empty() || _urls_in_part == max_urls_per_file ||
+                _bytes_in_part + _line.size() > max_bytes_per_file)
+            {
+                open_part();
+            }
+
+            _out << _line;
+            ++_urls_in_part;
+            _bytes_in_part += _line.size();
+            _parts.back()._lastmod = std::max(_parts.back()._lastmod, lastmod);
+        }
+
+        // Writes the final files, removes parts left over from previous
+        // larger sitemaps, and returns the paths that changed.
+        [[nodiscard]] std::vector<std::filesystem::path> finish()
+        {
+            if(_parts.empty())
+            {
+                open_part();
+            }
+
+            close_part();
+
+            std::vector<std::filesystem::path> changed;
+            const std::filesystem::path main = _dir / "sitemap.xml";
+
+            std::size_t first_stale_part = 0;
+
+            if(_parts.size() == 1)
+            {
+                if(replace_if_changed(_parts[0]._temp, main))
+                {
+                    changed.emplace_back(main);
+                }
+            }
+            else
+            {
+                std::filesystem::path index_temp = main;
+                index_temp += ".tmp";
+
+                std::ofstream index{index_temp, std::ios::binary};
+                index << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                         "<sitemapindex xmlns=\"http://www.sitemaps.org/"
+                         "schemas/sitemap/0.9\">\n";
+
+                for(std::size_t i = 0; i < _parts.size(); ++i)
+                {
+                    const std::filesystem::path target = part_path(i);
+                    if(replace_if_changed(_parts[i]._temp, target))
+                    {
+                        changed.emplace_back(target);
+                    }
+
+                    _line = "<sitemap><loc>";
+                    escape_xml_to(
+                        _line, _base_url + target.filename().string());
+                    _line += "</loc><lastmod>";
+                    impl::append_w3c_date(_line, _parts[i]._lastmod);
+                    _line += "</lastmod></sitemap>\n";
+
+                    index << _line;
+                }
+
+                index << "</sitemapindex>\n";
+                index.close();
+
+                if(replace_if_changed(index_temp, main))
+                {
+                    changed.emplace_back(main);
+                }
+
+                first_stale_part = _parts.size();
+            }
+
+            std::error_code ec;
+            for(std::size_t i = first_stale_part;
+                std::filesystem::remove(part_path(i), ec); ++i)
+            {
+            }
+
+            _parts.clear();
+            return changed;
+        }
+    };
+} // namespace vrdi
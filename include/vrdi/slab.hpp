@@ -0,0 +1,188 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+
+namespace vrdi
+{
+    // Append-only container with stable addresses, indexed by dense integer
+    // IDs. Elements live in segments of doubling size that are never moved
+    // or freed until destruction.
+    //
+    // * `create` atomically allocates the next index, default-constructs the
+    //   element, lets the caller fill it in and then publishes it.
+    //
+    // * Reads never lock: `get` is O(1) and `for_all` visits every published
+    //   element, in index order.
+    template <typename T>
+    class append_only_slab
+    {
+    private:
+        static constexpr std::size_t first_segment_size_log2{6};
+        static constexpr std::size_t first_segment_size{
+            std::size_t(1) << first_segment_size_log2};
+        static constexpr std::size_t max_segments{40};
+
+        struct slot
+        {
+            T _value{};
+            std::atomic<bool> _published{false};
+        };
+
+        std::array<std::atomic<slot*>, max_segments> _segments{};
+        std::atomic<std::size_t> _next_index{0};
+
+        [[nodiscard]] static constexpr std::size_t segment_size(
+            std::size_t segment) noexcept
+        {
+            return first_segment_size << segment;
+        }
+
+        [[nodiscard]] static std::size_t log2_floor(std::size_t x) noexcept
+        {
+            assert(x != 0);
+
+#if defined(__GNUC__)
+            return sizeof(unsigned long long) * 8 - 1 -
+                   static_cast<std::size_t>(
+                       __builtin_clzll(static_cast<unsigned long long>(x)));
+#else
+            std::size_t result = 0;
+            while(x >>= 1)
+            {
+                ++result;
+            }
+
+            return result;
+#endif
+        }
+
+        // Segment `k` holds indices `[F * (2^k - 1), F * (2^(k+1) - 1))`,
+        // where `F` is the size of the first segment.
+        [[nodiscard]] static std::size_t segment_of(std::size_t index) noexcept
+        {
+            return log2_floor((index >> first_segment_size_log2) + 1);
+        }
+
+        [[nodiscard]] static std::size_t offset_in_segment(
+            std::size_t index, std::size_t segment) noexcept
+        {
+            return index -
+                   first_segment_size * ((std::size_t(1) << segment) - 1);
+        }
+
+        [[nodiscard]] slot& slot_for_writing(std::size_t index)
+        {
+            const std::size_t segment = segment_of(index);
+            assert(segment < max_segments);
+
+            slot* s = _segments[segment].load(std::memory_order_acquire);
+
+            if(s == nullptr)
+            {
+                // Racing allocators: the first successful exchange wins.
+                slot* fresh = new slot[segment_size(segment)];
+
+                if(_segments[segment].compare_exchange_strong(s, fresh,
+                       std::memory_order_acq_rel, std::memory_order_acquire))
+                {
+                    s = fresh;
+                }
+                else
+                {
+                    delete[] fresh;
+                }
+            }
+
+            return s[offset_in_segment(index, segment)];
+        }
+
+        [[nodiscard]] slot* slot_for_reading(std::size_t index) const noexcept
+        {
+            const std::size_t segment = segment_of(index);
+            if(segment >= max_segments)
+            {
+                return nullptr;
+            }
+
+            slot* s = _segments[segment].load(std::memory_order_acquire);
+            return s == nullptr ? nullptr
+                                : &s[offset_in_segment(index, segment)];
+        }
+
+    public:
+        append_only_slab() = default;
+
+        append_only_slab(const append_only_slab&) = delete;
+        append_only_slab& operator=(const append_only_slab&) = delete;
+
+        ~append_only_slab()
+        {
+            for(std::atomic<slot*>& s : _segments)
+            {
+                delete[] s.load(std::memory_order_relaxed);
+            }
+        }
+
+        // Calls `f(index, element)` on a fresh element, then publishes it.
+        template <typename TF>
+        std::size_t create(TF&& f)
+        {
+            const std::size_t index =
+                _next_index.fetch_add(1, std::memory_order_relaxed);
+
+            slot& s = slot_for_writing(index);
+            f(index, s._value);
+            s._published.store(true, std::memory_order_release);
+
+            return index;
+        }
+
+        [[nodiscard]] const T& get(std::size_t index) const noexcept
+        {
+            const slot* s = slot_for_reading(index);
+
+            assert(s != nullptr);
+            assert(s->_published.load(std::memory_order_acquire));
+
+            return s->_value;
+        }
+
+        [[nodiscard]] std::size_t size() const noexcept
+        {
+            return _next_index.load(std::memory_order_acquire);
+        }
+
+        template <typename TF>
+        void for_all(TF&& f)
+        {
+            for(std::size_t i = 0, n = size(); i < n; ++i)
+            {
+                slot* s = slot_for_reading(i);
+
+                if(s != nullptr &&
+                    s->_published.load(std::memory_order_acquire))
+                {
+                    f(i, s->_value);
+                }
+            }
+        }
+
+        template <typename TF>
+        void for_all(TF&& f) const
+        {
+            for(std::size_t i = 0, n = size(); i < n; ++i)
+            {
+                const slot* s = slot_for_reading(i);
+
+                if(s != nullptr &&
+                    s->_published.load(std::memory_order_acquire))
+                {
+                    f(i, s->_value);
+                }
+            }
+        }
+    };
+} // namespace vrdi
@@ -0,0 +1,472 @@
+#pragma once
+
+#include "./hash.hpp"
+
+#include <cassert>
+#include <cstddef>
+#include <filesystem>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace vrdi
+{
+    class dictionary;
+    using dictionary_list = std::vector<dictionary>;
+
+    // Data used to expand a template: `{{Key}}` variables map to strings,
+    // `{{#Key}}...{{/Key}}` sections map to lists of nested dictionaries.
+    //
+    // A dictionary can be layered over an immutable, shared `base`: keys set
+    // on the layer shadow the base, everything else is looked up in the base.
+    // This allows per-render additions without copying large values.
+    class dictionary
+    {
+    private:
+        std::unordered_map<std::string, std::string> _values;
+        std::unordered_map<std::string, dictionary_list> _sections;
+        std::shared_ptr<const dictionary> _base;
+
+    public:
+        class proxy
+        {
+        private:
+            dictionary& _dictionary;
+            std::string _key;
+
+        public:
+            proxy(dictionary& d, std::string key) noexcept
+                : _dictionary{d}, _key{std::move(key)}
+            {
+            }
+
+            proxy& operator=(std::string x)
+            {
+                _dictionary._values[_key] = std::move(x);
+                return *this;
+            }
+
+            // Appends `x` to the section named after the key.
+            proxy& operator+=(dictionary x)
+            {
+                _dictionary._sections[_key].emplace_back(std::move(x));
+                return *this;
+            }
+        };
+
+        dictionary() = default;
+
+        dictionary(std::string key, std::string value)
+        {
+            _values.emplace(std::move(key), std::move(value));
+        }
+
+        explicit dictionary(std::shared_ptr<const dictionary> base) noexcept
+            : _base{std::move(base)}
+        {
+        }
+
+        [[nodiscard]] proxy operator[](std::string key) noexcept
+        {
+            return proxy{*this, std::move(key)};
+        }
+
+        [[nodiscard]] bool has(const std::string& key) const
+        {
+            return _values.count(key) != 0 || _sections.count(key) != 0 ||
+                   (_base != nullptr && _base->has(key));
+        }
+
+        [[nodiscard]] const std::string* find_value(
+            const std::string& key) const
+        {
+            const auto it = _values.find(key);
+            if(it != _values.end())
+            {
+                return &it->second;
+            }
+
+            return _base == nullptr ? nullptr : _base->find_value(key);
+        }
+
+        [[nodiscard]] const dictionary_list* find_section(
+            const std::string& key) const
+        {
+            const auto it = _sections.find(key);
+            if(it != _sections.end())
+            {
+                return &it->second;
+            }
+
+            return _base == nullptr ? nullptr : _base->find_section(key);
+        }
+
+        [[nodiscard]] const std::string& at(const std::string& key) const
+        {
+            if(const std::string* v = find_value(key))
+            {
+                return *v;
+            }
+
+            throw std::out_of_range{"dictionary has no value '" + key + "'"};
+        }
+    };
+
+    // Template expanded ahead of time, except for a few "hole" variables that
+    // are filled in later. Splicing values into the holes is a plain
+    // concatenation, so shared parts of many pages are only expanded once.
+    class prerendered_template
+    {
+        friend class compiled_template;
+
+    private:
+        // Always one more piece than holes: `p0 h0 p1 h1 ... pN`.
+        std::vector<std::string> _pieces{std::string{}};
+
+        // Index of the value filling each hole, in `fill`'s argument order.
+        std::vector<std::size_t> _holes;
+
+        // Number of values `fill` expects: one per hole name.
+        std::size_t _value_count{0};
+
+    public:
+        [[nodiscard]] std::string fill(
+            std::initializer_list<std::string_view> values) const
+        {
+            const std::string_view* v = values.begin();
+            assert(values.size() == _value_count);
+
+            std::size_t size = 0;
+            for(const std::string& p : _pieces)
+            {
+                size += p.size();
+            }
+
+            for(const std::size_t h : _holes)
+            {
+                size += v[h].size();
+            }
+
+            std::string result;
+            result.reserve(size);
+
+            for(std::size_t i = 0; i < _holes.size(); ++i)
+            {
+                result += _pieces[i];
+                result += v[_holes[i]];
+            }
+
+            result += _pieces.back();
+            return result;
+        }
+    };
+
+    // Template parsed once into a flat instruction list of literal spans,
+    // variable slots and section loops. Expanding only walks the
+    // instructions, without re-scanning the source text.
+    //
+    // Missing variables and sections expand to nothing. Lookups inside a
+    // section fall back to the enclosing dictionaries.
+    class compiled_template
+    {
+    private:
+        enum class op_kind
+        {
+            literal,
+            variable,
+            section_begin,
+            section_end
+        };
+
+        struct op
+        {
+            op_kind _kind;
+
+            // Literal span in `_source`.
+            std::size_t _offset;
+            std::size_t _size;
+
+            // Variable or section name.
+            std::string _key;
+
+            // For `section_begin`, index of the matching `section_end`.
+            std::size_t _jump;
+        };
+
+        std::string _source;
+        std::vector<op> _ops;
+
+        void push_literal(std::size_t offset, std::size_t size)
+        {
+            if(size == 0)
+            {
+                return;
+            }
+
+            // Merge adjacent literals, e.g. around a stray `{{`.
+            if(!_ops.empty() && _ops.back()._kind == op_kind::literal &&
+                _ops.back()._offset + _ops.back()._size == offset)
+            {
+                _ops.back()._size += size;
+                return;
+            }
+
+            _ops.push_back(op{op_kind::literal, offset, size, {}, 0});
+        }
+
+        void compile()
+        {
+            std::vector<std::size_t> open_sections;
+            std::size_t i = 0;
+
+            while(i < _source.size())
+            {
+                const std::size_t open = _source.find("{{", i);
+                if(open == std::string::npos)
+                {
+                    break;
+                }
+
+                const std::size_t close = _source.find("}}", open + 2);
+                if(close == std::string::npos)
+                {
+                    break;
+                }
+
+                push_literal(i, open - i);
+
+                std::string tag = _source.substr(open + 2, close - open - 2);
+                const std::size_t next = close + 2;
+
+                if(!tag.empty() && tag[0] == '#')
+                {
+                    open_sections.emplace_back(_ops.size());
+                    _ops.push_back(
+                        op{op_kind::section_begin, 0, 0, tag.substr(1), 0});
+                }
+                else if(!tag.empty() && tag[0] == '/' &&
+                        !open_sections.empty() &&
+                        _ops[open_sections.back()]._key == tag.substr(1))
+                {
+                    const std::size_t begin = open_sections.back();
+                    open_sections.pop_back();
+
+                    _ops[begin]._jump = _ops.size();
+                    _ops.push_back(op{
+                        op_kind::section_end, 0, 0, tag.substr(1), begin});
+                }
+                else if(!tag.empty() && tag[0] != '/')
+                {
+                    _ops.push_back(
+                        op{op_kind::variable, 0, 0, std::move(tag), 0});
+                }
+                else
+                {
+                    // Unbalanced section end: keep it verbatim.
+                    push_literal(open, next - open);
+                }
+
+                i = next;
+            }
+
+            push_literal(i, _source.size() - i);
+
+            // Unterminated sections: close them at the end of the template.
+            while(!open_sections.empty())
+            {
+                const std::size_t begin = open_sections.back();
+                open_sections.pop_back();
+
+                _ops[begin]._jump = _ops.size();
+                _ops.push_back(op{op_kind::section_end, 0, 0,
+                    _ops[begin]._key, begin});
+            }
+        }
+
+        [[nodiscard]] static const std::string* lookup_value(
+            const std::vector<const dictionary*>& scopes,
+            const std::string& key)
+        {
+            for(auto it = scopes.rbegin(); it != scopes.rend(); ++it)
+            {
+                if(const std::string* v = (*it)->find_value(key))
+                {
+                    return v;
+                }
+            }
+
+            return nullptr;
+        }
+
+        [[nodiscard]] static const dictionary_list* lookup_section(
+            const std::vector<const dictionary*>& scopes,
+            const std::string& key)
+        {
+            for(auto it = scopes.rbegin(); it != scopes.rend(); ++it)
+            {
+                if(const dictionary_list* s = (*it)->find_section(key))
+                {
+                    return s;
+                }
+            }
+
+            return nullptr;
+        }
+
+        [[nodiscard]] static std::size_t find_hole(
+            const std::vector<std::string>& holes, const std::string& key)
+        {
+            for(std::size_t i = 0; i < holes.size(); ++i)
+            {
+                if(holes[i] == key)
+                {
+                    return i;
+                }
+            }
+
+            return holes.size();
+        }
+
+        // Expands into `out._pieces.back()`. Variables named in `holes` are
+        // left unexpanded, unless a nested section scope shadows them.
+        void expand_range(prerendered_template& out, std::size_t begin,
+            std::size_t end, std::vector<const dictionary*>& scopes,
+            const std::vector<std::string>& holes) const
+        {
+            for(std::size_t i = begin; i < end; ++i)
+            {
+                const op& o = _ops[i];
+
+                switch(o._kind)
+                {
+                    case op_kind::literal:
+                        out._pieces.back().append(_source, o._offset, o._size);
+                        break;
+
+                    case op_kind::variable:
+                    {
+                        const std::size_t h = find_hole(holes, o._key);
+                        const std::string* v = lookup_value(scopes, o._key);
+
+                        // Only holes pay for the second lookup.
+                        const bool hole =
+                            h != holes.size() &&
+                            (v == nullptr ||
+                                v == scopes[0]->find_value(o._key));
+
+                        if(hole)
+                        {
+                            out._holes.emplace_back(h);
+                            out._pieces.emplace_back();
+                        }
+                        else if(v != nullptr)
+                        {
+                            out._pieces.back() += *v;
+                        }
+
+                        break;
+                    }
+
+                    case op_kind::section_begin:
+                        if(const dictionary_list* s =
+                                lookup_section(scopes, o._key))
+                        {
+                            for(const dictionary& d : *s)
+                            {
+                                scopes.emplace_back(&d);
+                                expand_range(
+                                    out, i + 1, o._jump, scopes, holes);
+                                scopes.pop_back();
+                            }
+                        }
+
+                        i = o._jump;
+                        break;
+
+                    case op_kind::section_end: break;
+                }
+            }
+        }
+
+    public:
+        explicit compiled_template(std::string source)
+            : _source{std::move(source)}
+        {
+            compile();
+        }
+
+        [[nodiscard]] std::string expand(const dictionary& d) const
+        {
+            prerendered_template result;
+            result._pieces.back().reserve(_source.size());
+
+            std::vector<const dictionary*> scopes{&d};
+            expand_range(result, 0, _ops.size(), scopes, {});
+
+            return std::move(result._pieces.back());
+        }
+
+        // Expands everything except the variables named in `holes`, which
+        // are filled in later through `prerendered_template::fill`, with
+        // values passed in the same order as `holes`.
+        [[nodiscard]] prerendered_template prerender(
+            const dictionary& d, const std::vector<std::string>& holes) const
+        {
+            prerendered_template result;
+            result._value_count = holes.size();
+
+            std::vector<const dictionary*> scopes{&d};
+            expand_range(result, 0, _ops.size(), scopes, holes);
+
+            return result;
+        }
+    };
+
+    // Thread-safe registry loading and compiling every template file once.
+    class template_registry
+    {
+    private:
+        mutable std::shared_mutex _mtx;
+        std::unordered_map<std::string,
+            std::shared_ptr<const compiled_template>>
+            _templates;
+
+    public:
+        [[nodiscard]] std::shared_ptr<const compiled_template> get(
+            const std::string& path)
+        {
+            {
+                std::shared_lock lock{_mtx};
+
+                const auto it = _templates.find(path);
+                if(it != _templates.end())
+                {
+                    return it->second;
+                }
+            }
+
+            // Compile outside of the lock. If several threads race on the
+            // same template, the first one to finish wins.
+            auto compiled = std::make_shared<const compiled_template>(
+                read_file(std::filesystem::path{path}));
+
+            std::unique_lock lock{_mtx};
+            return _templates.emplace(path, std::move(compiled)).first->second;
+        }
+
+        // Forgets all compiled templates, so that they are reloaded from disk
+        // on next use. Templates still in use stay alive until released.
+        void clear()
+        {
+            std::unique_lock lock{_mtx};
+            _templates.clear();
+        }
+    };
+} // namespace vrdi
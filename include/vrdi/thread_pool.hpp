@@ -0,0 +1,330 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace vrdi
+{
+    // Fixed-size work-stealing executor. Every worker owns a deque: tasks
+    // posted from a worker go to the back of its own deque and are popped
+    // LIFO by the owner, while idle workers steal FIFO from the front of
+    // other deques.
+    class thread_pool
+    {
+    public:
+        using task = std::function<void()>;
+
+    private:
+        struct task_queue
+        {
+            std::mutex _mtx;
+            std::deque<task> _tasks;
+        };
+
+        std::vector<std::unique_ptr<task_queue>> _queues;
+        std::vector<std::thread> _workers;
+        std::atomic<std::size_t> _next_queue{0};
+
+        // Number of tasks posted but not yet picked up by any thread. Only
+        // updated under the lock of the queue holding the task, so a task is
+        // always counted before it can be taken.
+        std::atomic<std::size_t> _pending{0};
+
+        std::mutex _sleep_mtx;
+        std::condition_variable _sleep_cv;
+        bool _stopping{false};
+
+        static constexpr std::chrono::microseconds contended_backoff{100};
+
+        static inline thread_local const thread_pool* tl_pool{nullptr};
+        static inline thread_local std::size_t tl_index{0};
+
+        [[nodiscard]] bool is_worker_thread() const noexcept
+        {
+            return tl_pool == this;
+        }
+
+        [[nodiscard]] std::optional<task> pop_back(std::size_t i)
+        {
+            task_queue& q = *_queues[i];
+            std::scoped_lock lock{q._mtx};
+
+            if(q._tasks.empty())
+            {
+                return std::nullopt;
+            }
+
+            task t = std::move(q._tasks.back());
+            q._tasks.pop_back();
+            --_pending;
+
+            return t;
+        }
+
+        [[nodiscard]] std::optional<task> steal_front(std::size_t i)
+        {
+            task_queue& q = *_queues[i];
+            std::unique_lock lock{q._mtx, std::try_to_lock};
+
+            if(!lock.owns_lock() || q._tasks.empty())
+            {
+                return std::nullopt;
+            }
+
+            task t = std::move(q._tasks.front());
+            q._tasks.pop_front();
+            --_pending;
+
+            return t;
+        }
+
+        [[nodiscard]] std::optional<task> find_task(std::size_t home)
+        {
+            if(is_worker_thread())
+            {
+                if(auto t = pop_back(home))
+                {
+                    return t;
+                }
+            }
+
+            for(std::size_t n = 0; n < _queues.size(); ++n)
+            {
+                if(auto t = steal_front((home + n) % _queues.size()))
+                {
+                    return t;
+                }
+            }
+
+            return std::nullopt;
+        }
+
+        void worker_loop(std::size_t i)
+        {
+            tl_pool = this;
+            tl_index = i;
+
+            while(true)
+            {
+                if(auto t = find_task(i))
+                {
+                    (*t)();
+                    continue;
+                }
+
+                // One pass found every queue empty or contended. Sleep until
+                // a task is posted, or only briefly if tasks are left behind
+                // contended locks, instead of spinning over the queues.
+                std::unique_lock lock{_sleep_mtx};
+
+                if(_pending > 0)
+                {
+                    _sleep_cv.wait_for(lock, contended_backoff);
+                }
+                else
+                {
+                    _sleep_cv.wait(
+                        lock, [this] { return _stopping || _pending > 0; });
+                }
+
+                if(_stopping && _pending == 0)
+                {
+                    return;
+                }
+            }
+        }
+
+    public:
+        explicit thread_pool(std::size_t worker_count)
+        {
+            worker_count = std::max(std::size_t(1), worker_count);
+
+            for(std::size_t i = 0; i < worker_count; ++i)
+            {
+                _queues.emplace_back(std::make_unique<task_queue>());
+            }
+
+            for(std::size_t i = 0; i < worker_count; ++i)
+            {
+                _workers.emplace_back([this, i] { worker_loop(i); });
+            }
+        }
+
+        ~thread_pool()
+        {
+            {
+                std::scoped_lock lock{_sleep_mtx};
+                _stopping = true;
+            }
+
+            _sleep_cv.notify_all();
+
+            for(std::thread& t : _workers)
+            {
+                t.join();
+            }
+        }
+
+        thread_pool(const thread_pool&) = delete;
+        thread_pool& operator=(const thread_pool&) = delete;
+
+        [[nodiscard]] std::size_t size() const noexcept
+        {
+            return _workers.size();
+        }
+
+        void post(task t)
+        {
+            const std::size_t i =
+                is_worker_thread() ? tl_index
+                                   : _next_queue++ % _queues.size();
+
+            {
+                task_queue& q = *_queues[i];
+                std::scoped_lock lock{q._mtx};
+                q._tasks.emplace_back(std::move(t));
+                ++_pending;
+            }
+
+            {
+                // A worker checking `_pending` holds this lock until it is
+                // waiting, so the notification cannot be lost.
+                std::scoped_lock lock{_sleep_mtx};
+            }
+
+            _sleep_cv.notify_one();
+        }
+
+        // Runs a single pending task on the calling thread, if there is one.
+        // Used by waiting threads to help instead of blocking.
+        bool run_one()
+        {
+            const std::size_t home =
+                is_worker_thread() ? tl_index
+                                   : _next_queue.load() % _queues.size();
+
+            if(auto t = find_task(home))
+            {
+                (*t)();
+                return true;
+            }
+
+            return false;
+        }
+    };
+
+    // Set of tasks running on a `thread_pool` that can be waited upon as a
+    // whole. Waiting executes pending tasks, so groups can be nested (e.g. a
+    // task fanning out into sub-tasks) without deadlocking the pool. The
+    // first exception thrown by any task is rethrown by `wait`.
+    class task_group
+    {
+    private:
+        thread_pool& _pool;
+
+        // Guards `_outstanding` and `_error`. A finishing task releases it as
+        // its last access to the group: `wait` cannot return, and the group
+        // cannot be destroyed, while a task still holds it.
+        std::mutex _mtx;
+        std::condition_variable _cv;
+        std::size_t _outstanding{0};
+        std::exception_ptr _error;
+
+        void on_task_done()
+        {
+            std::scoped_lock lock{_mtx};
+
+            if(--_outstanding == 0)
+            {
+                _cv.notify_all();
+            }
+        }
+
+        [[nodiscard]] bool done()
+        {
+            std::scoped_lock lock{_mtx};
+            return _outstanding == 0;
+        }
+
+    public:
+        explicit task_group(thread_pool& pool) noexcept : _pool{pool}
+        {
+        }
+
+        ~task_group()
+        {
+            try
+            {
+                wait();
+            }
+            catch(...)
+            {
+            }
+        }
+
+        task_group(const task_group&) = delete;
+        task_group& operator=(const task_group&) = delete;
+
+        template <typename TF>
+        void run(TF&& f)
+        {
+            {
+                std::scoped_lock lock{_mtx};
+                ++_outstanding;
+            }
+
+            _pool.post(
+                [this, f = std::forward<TF>(f)]() mutable
+                {
+                    try
+                    {
+                        f();
+                    }
+                    catch(...)
+                    {
+                        std::scoped_lock lock{_mtx};
+                        if(!_error)
+                        {
+                            _error = std::current_exception();
+                        }
+                    }
+
+                    on_task_done();
+                });
+        }
+
+        void wait()
+        {
+            while(!done())
+            {
+                if(_pool.run_one())
+                {
+                    continue;
+                }
+
+                std::unique_lock lock{_mtx};
+                _cv.wait_for(lock, std::chrono::milliseconds{1},
+                    [this] { return _outstanding == 0; });
+            }
+
+            std::scoped_lock lock{_mtx};
+            if(_error)
+            {
+                std::exception_ptr e = std::exchange(_error, nullptr);
+                std::rethrow_exception(e);
+            }
+        }
+    };
+} // namespace vrdi
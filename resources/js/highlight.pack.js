@@ -1 +0,0 @@
-var hljs=new function(){function q(a){return a.replace(/&/gm,"&amp;").replace(/</gm,"&lt;").replace(/>/gm,"&gt;")}function A(a){for(var b=a.firstChild;b;b=b.nextSibling){if(b.nodeName=="CODE"){return b}if(!(b.nodeType==3&&b.nodeValue.match(/\s+/))){break}}}function u(a,b){return Array.prototype.map.call(a.childNodes,function(c){if(c.nodeType==3){return b?c.nodeValue.replace(/\n/g,""):c.nodeValue}if(c.nodeName=="BR"){return"\n"}return u(c,b)}).join("")}function B(a){var b=(a.className+" "+a.parentNode.className).split(/\s+/);b=b.map(function(d){return d.replace(/^language-/,"")});for(var c=0;c<b.length;c++){if(x[b[c]]||b[c]=="no-highlight"){return b[c]}}}function z(a){var c=[];(function b(f,e){for(var d=f.firstChild;d;d=d.nextSibling){if(d.nodeType==3){e+=d.nodeValue.length}else{if(d.nodeName=="BR"){e+=1}else{if(d.nodeType==1){c.push({event:"start",offset:e,node:d});e=b(d,e);c.push({event:"stop",offset:e,node:d})}}}}return e})(a,0);return c}function s(f,h,g){var c=0;var e="";var a=[];function j(){if(f.length&&h.length){if(f[0].offset!=h[0].offset){return(f[0].offset<h[0].offset)?f:h}else{return h[0].event=="start"?f:h}}else{return f.length?f:h}}function k(l){function m(n){return" "+n.nodeName+'="'+q(n.value)+'"'}return"<"+l.nodeName+Array.prototype.map.call(l.attributes,m).join("")+">"}while(f.length||h.length){var i=j().splice(0,1)[0];e+=q(g.substr(c,i.offset-c));c=i.offset;if(i.event=="start"){e+=k(i.node);a.push(i.node)}else{if(i.event=="stop"){var d,b=a.length;do{b--;d=a[b];e+=("</"+d.nodeName.toLowerCase()+">")}while(d!=i.node);a.splice(b,1);while(b<a.length){e+=k(a[b]);b++}}}}return e+q(g.substr(c))}function w(a){function c(d,e){return RegExp(d,"m"+(a.cI?"i":"")+(e?"g":""))}function b(k,e){if(k.compiled){return}k.compiled=true;var h=[];if(k.k){var i={};function j(l,m){m.split(" ").forEach(function(D){var n=D.split("|");i[n[0]]=[l,n[1]?Number(n[1]):1];h.push(n[0])})}k.lR=c(k.l||hljs.IR,true);if(typeof k.k=="string"){j("keyword",k.k)}else{for(var d in k.k){if(!k.k.hasOwnProperty(d)){continue}j(d,k.k[d])}}k.k=i}if(e){if(k.bWK){k.b="\\b("+h.join("|")+")\\s"}k.bR=c(k.b?k.b:"\\B|\\b");if(!k.e&&!k.eW){k.e="\\B|\\b"}if(k.e){k.eR=c(k.e)}k.tE=k.e||"";if(k.eW&&e.tE){k.tE+=(k.e?"|":"")+e.tE}}if(k.i){k.iR=c(k.i)}if(k.r===undefined){k.r=1}if(!k.c){k.c=[]}for(var f=0;f<k.c.length;f++){if(k.c[f]=="self"){k.c[f]=k}b(k.c[f],k)}if(k.starts){b(k.starts,e)}var g=[];for(var f=0;f<k.c.length;f++){g.push(k.c[f].b)}if(k.tE){g.push(k.tE)}if(k.i){g.push(k.i)}k.t=g.length?c(g.join("|"),true):{exec:function(l){return null}}}b(a)}function y(K,l){function Q(E,F){for(var C=0;C<F.c.length;C++){var D=F.c[C].bR.exec(E);if(D&&D.index==0){return F.c[C]}}}function n(C,D){if(C.e&&C.eR.test(D)){return C}if(C.eW){return n(C.parent,D)}}function m(D,C){return C.i&&C.iR.test(D)}function c(C,E){var D=k.cI?E[0].toLowerCase():E[0];return C.k.hasOwnProperty(D)&&C.k[D]}function h(){var D=q(g);if(!P.k){return D}var E="";var F=0;P.lR.lastIndex=0;var C=P.lR.exec(D);while(C){E+=D.substr(F,C.index-F);var G=c(P,C);if(G){i+=G[1];E+='<span class="'+G[0]+'">'+C[0]+"</span>"}else{E+=C[0]}F=P.lR.lastIndex;C=P.lR.exec(D)}return E+D.substr(F)}function a(){if(P.sL&&!x[P.sL]){return q(g)}var C=P.sL?y(P.sL,g):v(g);if(P.r>0){i+=C.keyword_count;N+=C.r}return'<span class="'+C.language+'">'+C.value+"</span>"}function b(){return P.sL!==undefined?a():h()}function d(C,E){var D=C.cN?'<span class="'+C.cN+'">':"";if(C.rB){e+=D;g=""}else{if(C.eB){e+=q(E)+D;g=""}else{e+=D;g=E}}P=Object.create(C,{parent:{value:P}});N+=C.r}function L(D,E){g+=D;if(E===undefined){e+=b();return 0}var C=Q(E,P);if(C){e+=b();d(C,E);return C.rB?0:E.length}var F=n(P,E);if(F){if(!(F.rE||F.eE)){g+=E}e+=b();do{if(P.cN){e+="</span>"}P=P.parent}while(P!=F.parent);if(F.eE){e+=q(E)}g="";if(F.starts){d(F.starts,"")}return F.rE?0:E.length}if(m(E,P)){throw"Illegal"}g+=E;return E.length||1}var k=x[K];w(k);var P=k;var g="";var N=0;var i=0;var e="";try{var j,M,O=0;while(true){P.t.lastIndex=O;j=P.t.exec(l);if(!j){break}M=L(l.substr(O,j.index-O),j[0]);O=j.index+M}L(l.substr(O));return{r:N,keyword_count:i,value:e,language:K}}catch(f){if(f=="Illegal"){return{r:0,keyword_count:0,value:q(l)}}else{throw f}}}function v(a){var e={keyword_count:0,r:0,value:q(a)};var c=e;for(var d in x){if(!x.hasOwnProperty(d)){continue}var b=y(d,a);b.language=d;if(b.keyword_count+b.r>c.keyword_count+c.r){c=b}if(b.keyword_count+b.r>e.keyword_count+e.r){c=e;e=b}}if(c.language){e.second_best=c}return e}function t(a,b,c){if(b){a=a.replace(/^((<[^>]+>|\t)+)/gm,function(g,d,e,f){return d.replace(/\t/g,b)})}if(c){a=a.replace(/\n/g,"<br>")}return a}function p(a,g,c){var f=u(a,c);var h=B(a);if(h=="no-highlight"){return}var e=h?y(h,f):v(f);h=e.language;var d=z(a);if(d.length){var b=document.createElement("pre");b.innerHTML=e.value;e.value=s(d,z(b),f)}e.value=t(e.value,g,c);var i=a.className;if(!i.match("(\\s|^)(language-)?"+h+"(\\s|$)")){i=i?(i+" "+h):h}a.innerHTML=e.value;a.className=i;a.result={language:h,kw:e.keyword_count,re:e.r};if(e.second_best){a.second_best={language:e.second_best.language,kw:e.second_best.keyword_count,re:e.second_best.r}}}function o(){if(o.called){return}o.called=true;Array.prototype.map.call(document.getElementsByTagName("pre"),A).filter(Boolean).forEach(function(a){p(a,hljs.tabReplace)})}function r(){window.addEventListener("DOMContentLoaded",o,false);window.addEventListener("load",o,false)}var x={};this.LANGUAGES=x;this.highlight=y;this.highlightAuto=v;this.fixMarkup=t;this.highlightBlock=p;this.initHighlighting=o;this.initHighlightingOnLoad=r;this.IR="[a-zA-Z][a-zA-Z0-9_]*";this.UIR="[a-zA-Z_][a-zA-Z0-9_]*";this.NR="\\b\\d+(\\.\\d+)?";this.CNR="(\\b0[xX][a-fA-F0-9]+|(\\b\\d+(\\.\\d*)?|\\.\\d+)([eE][-+]?\\d+)?)";this.BNR="\\b(0b[01]+)";this.RSR="!|!=|!==|%|%=|&|&&|&=|\\*|\\*=|\\+|\\+=|,|\\.|-|-=|/|/=|:|;|<|<<|<<=|<=|=|==|===|>|>=|>>|>>=|>>>|>>>=|\\?|\\[|\\{|\\(|\\^|\\^=|\\||\\|=|\\|\\||~";this.BE={b:"\\\\[\\s\\S]",r:0};this.ASM={cN:"string",b:"'",e:"'",i:"\\n",c:[this.BE],r:0};this.QSM={cN:"string",b:'"',e:'"',i:"\\n",c:[this.BE],r:0};this.CLCM={cN:"comment",b:"//",e:"$"};this.CBLCLM={cN:"comment",b:"/\\*",e:"\\*/"};this.HCM={cN:"comment",b:"#",e:"$"};this.NM={cN:"number",b:this.NR,r:0};this.CNM={cN:"number",b:this.CNR,r:0};this.BNM={cN:"number",b:this.BNR,r:0};this.inherit=function(b,a){var d={};for(var c in b){d[c]=b[c]}if(a){for(var c in a){d[c]=a[c]}}return d}}();hljs.LANGUAGES.bash=function(j){var l="true false";var n="if then else elif fi for break continue while in do done echo exit return set declare";var p={cN:"variable",b:"\\$[a-zA-Z0-9_#]+"};var i={cN:"variable",b:"\\${([^}]|\\\\})+}"};var k={cN:"string",b:'"',e:'"',i:"\\n",c:[j.BE,p,i],r:0};var o={cN:"string",b:"'",e:"'",c:[{b:"''"}],r:0};var m={cN:"test_condition",b:"",e:"",c:[k,o,p,i],k:{literal:l},r:0};return{k:{keyword:n,literal:l},c:[{cN:"shebang",b:"(#!\\/bin\\/bash)|(#!\\/bin\\/sh)",r:10},p,i,j.HCM,k,o,j.inherit(m,{b:"\\[ ",e:" \\]",r:0}),j.inherit(m,{b:"\\[\\[ ",e:" \\]\\]"})]}}(hljs);hljs.LANGUAGES.json=function(h){var j={literal:"true false null"};var k=[h.QSM,h.CNM];var l={cN:"value",e:",",eW:true,eE:true,c:k,k:j};var g={b:"{",e:"}",c:[{cN:"attribute",b:'\\s*"',e:'"\\s*:\\s*',eB:true,eE:true,c:[h.BE],i:"\\n",starts:l}],i:"\\S"};var i={b:"\\[",e:"\\]",c:[h.inherit(l,{cN:null})],i:"\\S"};k.splice(k.length,0,g,i);return{c:k,k:j,i:"\\S"}}(hljs);hljs.LANGUAGES.cpp=function(d){var c={keyword:"false int float while private char catch export virtual operator sizeof dynamic_cast|10 typedef const_cast|10 const struct for static_cast|10 union namespace unsigned long throw volatile static protected bool template mutable if public friend do return goto auto void enum else break new extern using true class asm case typeid short reinterpret_cast|10 default double register explicit signed typename try this switch continue wchar_t inline delete alignof char16_t char32_t constexpr decltype noexcept nullptr static_assert thread_local restrict _Bool complex",built_in:"std string cin cout cerr clog stringstream istringstream ostringstream auto_ptr deque list queue stack vector map set bitset multiset multimap unordered_set unordered_map unordered_multiset unordered_multimap array shared_ptr"};return{k:c,i:"</",c:[d.CLCM,d.CBLCLM,d.QSM,{cN:"string",b:"'\\\\?.",e:"'",i:"."},{cN:"number",b:"\\b(\\d+(\\.\\d*)?|\\.\\d+)(u|U|l|L|ul|UL|f|F)"},d.CNM,{cN:"preprocessor",b:"#",e:"$"},{cN:"stl_container",b:"\\b(deque|list|queue|stack|vector|map|set|bitset|multiset|multimap|unordered_map|unordered_set|unordered_multiset|unordered_multimap|array)\\s*<",e:">",k:c,r:10,c:["self"]}]}}(hljs);
\ No newline at end of file
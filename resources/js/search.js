@@ -0,0 +1,382 @@
+// Client-side search over the binary index generated at build time
+// (`/search.idx`, see `include/vrdi/search_index.hpp` for the format).
+
+var vrdiSearch = (function() {
+    // Must be kept in sync with `vrdi::stem`.
+    var stemRules = [
+        ["ations", "ate"], ["ation", "ate"], ["ies", "y"], ["ing", ""],
+        ["ed", ""], ["ly", ""], ["es", ""], ["s", ""]
+    ];
+
+    function stem(word) {
+        for(var i = 0; i < stemRules.length; ++i)
+        {
+            var suffix = stemRules[i][0];
+            var replacement = stemRules[i][1];
+
+            if(word.length < suffix.length ||
+               word.slice(word.length - suffix.length) !== suffix)
+            {
+                continue;
+            }
+
+            if(suffix === "s" && word.slice(-2) === "ss")
+            {
+                break;
+            }
+
+            var stemSize = word.length - suffix.length;
+            if(stemSize + replacement.length >= 3)
+            {
+                word = word.slice(0, stemSize) + replacement;
+            }
+
+            break;
+        }
+
+        return word;
+    }
+
+    function tokenize(text) {
+        var tokens = text.toLowerCase().split(/[^a-z0-9]+/);
+        var result = [];
+
+        for(var i = 0; i < tokens.length; ++i)
+        {
+            if(tokens[i].length >= 2 && tokens[i].length <= 32)
+            {
+                result.push(tokens[i]);
+            }
+        }
+
+        return result;
+    }
+
+    // Number of terms `vrdi::for_each_term` finds in `text`. Must follow the
+    // same rules: it tells where the title's positions end.
+    function countTerms(text) {
+        var count = 0;
+        var size = 0;
+
+        function emit() {
+            if(size >= 2 && size <= 32)
+            {
+                ++count;
+            }
+
+            size = 0;
+        }
+
+        for(var i = 0; i < text.length; ++i)
+        {
+            var c = text.charAt(i);
+
+            if(c === "<")
+            {
+                emit();
+
+                var closing = ">";
+
+                if(text.substr(i, 7) === "<script")
+                {
+                    closing = "</script>";
+                }
+                else if(text.substr(i, 6) === "<style")
+                {
+                    closing = "</style>";
+                }
+
+                var end = text.indexOf(closing, i);
+                if(end === -1)
+                {
+                    return count;
+                }
+
+                i = end + closing.length - 1;
+            }
+            else if(c === "&")
+            {
+                // Entities separate tokens: skip to the terminating `;`.
+                emit();
+
+                var semicolon = text.indexOf(";", i);
+                if(semicolon !== -1 && semicolon - i <= 8)
+                {
+                    i = semicolon;
+                }
+            }
+            else if(/[A-Za-z0-9]/.test(c))
+            {
+                ++size;
+            }
+            else
+            {
+                emit();
+            }
+        }
+
+        emit();
+        return count;
+    }
+
+    function Reader(buffer) {
+        this.bytes = new Uint8Array(buffer);
+        this.pos = 0;
+        this.decoder = new TextDecoder("utf-8");
+    }
+
+    Reader.prototype.varint = function() {
+        var result = 0;
+        var shift = 1;
+
+        while(true)
+        {
+            var b = this.bytes[this.pos++];
+            result += (b & 0x7F) * shift;
+
+            if(b < 0x80)
+            {
+                return result;
+            }
+
+            shift *= 128;
+        }
+    };
+
+    Reader.prototype.string = function() {
+        var size = this.varint();
+        var s = this.decoder.decode(
+            this.bytes.subarray(this.pos, this.pos + size));
+
+        this.pos += size;
+        return s;
+    };
+
+    function Index(buffer) {
+        var r = new Reader(buffer);
+
+        if(r.decoder.decode(r.bytes.subarray(0, 4)) !== "VRSI")
+        {
+            throw new Error("not a search index");
+        }
+
+        r.pos = 4;
+        if(r.varint() !== 1)
+        {
+            throw new Error("unsupported search index version");
+        }
+
+        this.docs = [];
+        var docCount = r.varint();
+
+        for(var d = 0; d < docCount; ++d)
+        {
+            var url = r.string();
+            var title = r.string();
+
+            // Title terms come first: they are ranked higher.
+            this.docs.push({url: url, title: title,
+                            titleTerms: countTerms(title)});
+        }
+
+        // Sorted, for prefix lookups.
+        this.terms = [];
+        this.postings = {};
+
+        var termCount = r.varint();
+        for(var t = 0; t < termCount; ++t)
+        {
+            var term = r.string();
+            var list = [];
+
+            var postingCount = r.varint();
+            var doc = 0;
+
+            for(var p = 0; p < postingCount; ++p)
+            {
+                doc += r.varint();
+
+                var positions = [];
+                var positionCount = r.varint();
+                var position = 0;
+
+                for(var q = 0; q < positionCount; ++q)
+                {
+                    position += r.varint();
+                    positions.push(position);
+                }
+
+                list.push({doc: doc, positions: positions});
+            }
+
+            this.terms.push(term);
+            this.postings[term] = list;
+        }
+    }
+
+    // Postings of every term starting with `prefix`, merged by document.
+    Index.prototype.prefixPostings = function(prefix) {
+        var lo = 0;
+        var hi = this.terms.length;
+
+        while(lo < hi)
+        {
+            var mid = (lo + hi) >> 1;
+            if(this.terms[mid] < prefix) lo = mid + 1; else hi = mid;
+        }
+
+        var byDoc = {};
+        for(var i = lo; i < this.terms.length &&
+                        this.terms[i].lastIndexOf(prefix, 0) === 0; ++i)
+        {
+            var list = this.postings[this.terms[i]];
+            for(var j = 0; j < list.length; ++j)
+            {
+                var e = byDoc[list[j].doc] ||
+                        (byDoc[list[j].doc] = {doc: list[j].doc, positions: []});
+
+                e.positions = e.positions.concat(list[j].positions);
+            }
+        }
+
+        var result = [];
+        for(var k in byDoc)
+        {
+            byDoc[k].positions.sort(function(a, b) { return a - b; });
+            result.push(byDoc[k]);
+        }
+
+        return result;
+    };
+
+    // Returns matching documents, best first. All words must match; the last
+    // one also matches as a prefix, for search-as-you-type. A query wrapped
+    // in double quotes only matches the exact phrase.
+    Index.prototype.query = function(text) {
+        var phrase = /^\s*".*"\s*$/.test(text);
+        var words = tokenize(text);
+
+        if(words.length === 0)
+        {
+            return [];
+        }
+
+        var lists = [];
+        for(var i = 0; i < words.length; ++i)
+        {
+            var last = i === words.length - 1 && !phrase;
+            lists.push(last ? this.prefixPostings(stem(words[i]))
+                            : (this.postings[stem(words[i])] || []));
+        }
+
+        var positionsByDoc = [];
+
+        for(var l = 0; l < lists.length; ++l)
+        {
+            var map = {};
+            for(var j = 0; j < lists[l].length; ++j)
+            {
+                map[lists[l][j].doc] = lists[l][j].positions;
+            }
+
+            positionsByDoc.push(map);
+        }
+
+        var results = [];
+        for(var doc in positionsByDoc[0])
+        {
+            var score = 0;
+            var ok = true;
+
+            for(var w = 0; w < positionsByDoc.length && ok; ++w)
+            {
+                var positions = positionsByDoc[w][doc];
+                ok = positions !== undefined;
+
+                if(ok)
+                {
+                    for(var p = 0; p < positions.length; ++p)
+                    {
+                        score += positions[p] < this.docs[doc].titleTerms ? 10 : 1;
+                    }
+                }
+            }
+
+            if(ok && phrase)
+            {
+                ok = positionsByDoc[0][doc].some(function(start) {
+                    for(var w = 1; w < positionsByDoc.length; ++w)
+                    {
+                        if(positionsByDoc[w][doc].indexOf(start + w) === -1)
+                        {
+                            return false;
+                        }
+                    }
+
+                    return true;
+                });
+            }
+
+            if(ok)
+            {
+                results.push({doc: this.docs[doc], score: score});
+            }
+        }
+
+        results.sort(function(a, b) { return b.score - a.score; });
+        return results.map(function(r) { return r.doc; });
+    };
+
+    function load(url) {
+        return fetch(url)
+            .then(function(response) { return response.arrayBuffer(); })
+            .then(function(buffer) { return new Index(buffer); });
+    }
+
+    // Wires a text input to a list element, loading the index on first use.
+    function attach(input, results, url) {
+        var index = null;
+
+        input.addEventListener("focus", function() {
+            index = index || load(url || "/search.idx");
+        });
+
+        input.addEventListener("input", function() {
+            var text = input.value;
+            index = index || load(url || "/search.idx");
+
+            index.then(function(i) {
+                if(input.value !== text)
+                {
+                    return;
+                }
+
+                results.innerHTML = "";
+                var matches = i.query(text).slice(0, 10);
+
+                for(var m = 0; m < matches.length; ++m)
+                {
+                    var a = document.createElement("a");
+                    a.href = matches[m].url;
+                    a.textContent = matches[m].title;
+
+                    var li = document.createElement("li");
+                    li.appendChild(a);
+                    results.appendChild(li);
+                }
+            });
+        });
+    }
+
+    return {load: load, attach: attach, stem: stem};
+})();
+
+(function() {
+    var input = document.getElementById("searchInput");
+    var results = document.getElementById("searchResults");
+
+    if(input && results)
+    {
+        vrdiSearch.attach(input, results);
+    }
+})();
@@ -1,8 +1,5 @@
 #!/bin/bash
 
-./build/vittorioromeo_dot_info && \
-cd result && \
-(cd ./index/blog && ln -s ../../../resources .) && \
-killall python3 ; \
-(python3 -m http.server 8080 &) && \
-chromium "http://localhost:8080"
+./build/vittorioromeo_dot_info --watch --serve 8080 &
+sleep 1 && chromium "http://localhost:8080"
+wait
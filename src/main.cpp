@@ -1,16 +1,49 @@
 #include <SSVUtils/Core/Core.hpp>
 #include <SSVUtils/Json/Json.hpp>
-#include <SSVUtils/TemplateSystem/TemplateSystem.hpp>
-#include <future>
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <filesystem>
+#include <limits>
 #include <map>
 #include <memory>
 #include <mutex>
 #include <optional>
+#include <set>
 #include <sstream>
 #include <string>
+#include <thread>
+#include <tuple>
 #include <vector>
+#include <vrdi/build_cache.hpp>
+#include <vrdi/compression.hpp>
+#include <vrdi/date.hpp>
+#include <vrdi/escape.hpp>
+#include <vrdi/feed.hpp>
+#include <vrdi/file_watcher.hpp>
+#include <vrdi/hash.hpp>
+#include <vrdi/highlight.hpp>
+#include <vrdi/html_rewriter.hpp>
+#include <vrdi/http_server.hpp>
+#include <vrdi/mathml.hpp>
+#include <vrdi/output_sink.hpp>
+#include <vrdi/profiler.hpp>
+#include <vrdi/search_index.hpp>
+#include <vrdi/sitemap.hpp>
+#include <vrdi/slab.hpp>
+#include <vrdi/template_system.hpp>
+#include <vrdi/thread_pool.hpp>
 #include <vrm/core/strong_typedef.hpp>
 
+extern "C"
+{
+#include <mkdio.h>
+}
+
 inline constexpr bool verbose{false};
 
 using namespace std::string_literals;
@@ -38,6 +71,48 @@ VRM_CORE_STRONG_TYPEDEF(sz_t, page_id);
 VRM_CORE_STRONG_TYPEDEF(sz_t, entry_id);
 #pragma GCC diagnostic pop
 
+namespace settings
+{
+    enum class markdown_backend
+    {
+        // In-process rendering through `libmarkdown`.
+        discount,
+
+        // Legacy `pp` + `pandoc` shell pipeline.
+        pandoc
+    };
+
+    // Set once by `main` from the command line, before any work starts.
+    inline markdown_backend md_backend{markdown_backend::discount};
+
+    // Reuse rendered fragments and unchanged pages from previous builds.
+    inline bool use_cache{true};
+
+    // Wipe the result folder and force a full rebuild.
+    inline bool clean{false};
+
+    // Leave outputs whose contents did not change untouched.
+    inline bool skip_unchanged{true};
+
+    // Write precompressed sidecars next to every text output.
+    inline bool precompress{true};
+
+    // Keep running after the first build, rebuilding on source changes.
+    inline bool watch{false};
+
+    // Number of worker threads. Zero means one per hardware thread.
+    inline std::size_t jobs{0};
+
+    // Serve the result folder on this port after building, if set.
+    inline std::optional<std::uint16_t> serve_port;
+
+    // Record timings of every build phase and write them as a trace.
+    inline bool profile{false};
+
+    // Log the path of every changed output, not only their count.
+    inline bool list_changed{false};
+} // namespace settings
+
 namespace constant::folder::name
 {
     const std::string pages{"_pages"};
@@ -48,6 +123,9 @@ namespace constant::folder::name
     const std::string resources{"resources"};
     const std::string result{"result"};
     const std::string temp{"temp"};
+    const std::string templates{"templates"};
+    const std::string cache{".vrdi-cache"};
+    const std::string tags{"tags"};
 } // namespace constant::folder::name
 
 namespace constant::folder::path
@@ -55,7 +133,10 @@ namespace constant::folder::path
     const std::string content{folder::name::content + "/"};
     const std::string pages{content + folder::name::pages + "/"};
     const std::string result{folder::name::result + "/"};
+    const std::string tags{result + folder::name::tags + "/"};
     const std::string temp{folder::name::temp + "/"};
+    const std::string templates{folder::name::templates + "/"};
+    const std::string cache{folder::name::cache + "/"};
     const std::string resources{"/" + folder::name::resources};
 } // namespace constant::folder::path
 
@@ -65,58 +146,84 @@ namespace constant::file
     const std::string main_menu_json{"_menu.json"};
 } // namespace constant::file
 
+namespace constant::template_path
+{
+    const std::string page{folder::path::templates + "page.tpl"};
+    const std::string main{folder::path::templates + "base/main.tpl"};
+    const std::string main_menu{folder::path::templates + "base/mainMenu.tpl"};
+    const std::string disqus{folder::path::templates + "other/disqus.tpl"};
+    const std::string header{folder::path::templates + "entries/header.tpl"};
+    const std::string mathjax{folder::path::templates + "other/mathjax.tpl"};
+
+    // Templates used directly by the generator, for every page.
+    const std::vector<std::string> shared{
+        page, main, main_menu, disqus, mathjax};
+} // namespace constant::template_path
+
+namespace constant::cache
+{
+    // Bump whenever the generator's output changes for the same inputs, to
+    // invalidate all cached fragments and pages.
+    const std::string format_version{"vrdi-cache-9"};
+} // namespace constant::cache
+
 namespace constant::url::path
 {
     const std::string website{"https://vittorioromeo.info/"};
 } // namespace constant::url::path
 
-namespace utils
+namespace constant::tags
 {
-    [[nodiscard]] std::string get_pubdate_mo(const std::string& mo)
-    {
-        if(mo == "january") return "Jan";
-        if(mo == "february") return "Feb";
-        if(mo == "march") return "Mar";
-        if(mo == "april") return "Apr";
-        if(mo == "may") return "May";
-        if(mo == "june") return "Jun";
-        if(mo == "july") return "Jul";
-        if(mo == "august") return "Aug";
-        if(mo == "september") return "Sep";
-        if(mo == "october") return "Oct";
-        if(mo == "november") return "Nov";
-        if(mo == "december") return "Dec";
-
-        assert(false);
-        return "Dec";
-    }
-
-    [[nodiscard]] std::string to_pubdate(const std::string& date)
-    {
-        int d, y;
-        std::string month;
+    const sz_t entries_per_subpage{10};
+    const sz_t feed_items{20};
+} // namespace constant::tags
 
-        std::istringstream iss;
-        iss.str(date);
+namespace constant::pool
+{
+    // Largest accepted `--jobs` value.
+    const sz_t max_jobs{1024};
+} // namespace constant::pool
 
-        iss >> d >> month >> y;
+namespace constant::profile
+{
+    // Chrome trace-event JSON, written after every profiled build.
+    const std::string trace_path{"profile.json"};
+    const sz_t summary_rows{15};
+} // namespace constant::profile
 
-        return std::to_string(d) + " " + get_pubdate_mo(month) + " " +
-               std::to_string(y) + " 00:00:00 GMT";
-    }
+namespace constant::feed
+{
+    const std::string title{"vittorio romeo's website"};
+    const std::string description{"Vittorio Romeo's personal blog/website"};
+    const std::string author{"Vittorio Romeo"};
+    const std::string language{"en-us"};
+} // namespace constant::feed
 
-    template <typename T>
-    [[nodiscard]] std::size_t find_nth(const std::string& haystack, sz_t pos,
-        const T& needle, sz_t nth) noexcept
+namespace utils
+{
+    // File name for a tag: lowercase alphanumerics, `+` spelled as `p` (so
+    // that "c++" becomes "cpp"), anything else replaced by `-`.
+    // Distinct tags can share a slug, e.g. "C++" and "cpp": see
+    // `build_tag_index`.
+    [[nodiscard]] std::string tag_slug(const std::string& tag)
     {
-        auto found_pos = haystack.find(needle, pos);
+        std::string result;
+        result.reserve(tag.size());
 
-        if(nth == 0 || std::string::npos == found_pos)
+        for(const char c : tag)
         {
-            return found_pos;
+            if(std::isalnum(static_cast<unsigned char>(c)))
+            {
+                result += static_cast<char>(
+                    std::tolower(static_cast<unsigned char>(c)));
+            }
+            else
+            {
+                result += c == '+' ? 'p' : '-';
+            }
         }
 
-        return find_nth(haystack, found_pos + 1, needle, nth - 1);
+        return result;
     }
 
     template <typename T>
@@ -133,9 +240,81 @@ namespace utils
         system(cmd.c_str());
     }
 
+    [[nodiscard]] std::string read_cmd_output(const std::string& cmd)
+    {
+        std::string result;
+
+        FILE* pipe = popen(cmd.c_str(), "r");
+        if(pipe == nullptr)
+        {
+            return result;
+        }
+
+        char buf[256];
+        while(fgets(buf, sizeof(buf), pipe) != nullptr)
+        {
+            result += buf;
+        }
+
+        pclose(pipe);
+        return result;
+    }
+
+    [[nodiscard]] vrdi::build_cache& cache()
+    {
+        static vrdi::build_cache instance{
+            constant::folder::path::cache, settings::use_cache};
+
+        return instance;
+    }
+
+    // Timings of the current build, recorded only with `--profile`.
+    [[nodiscard]] vrdi::profiler& profiler()
+    {
+        static vrdi::profiler instance;
+        return instance;
+    }
+
+    // Times the enclosing scope as `name` under `category`, a string literal.
+    [[nodiscard]] vrdi::profile_scope profile(
+        std::string_view category, std::string_view name)
+    {
+        return vrdi::profile_scope{profiler(), category, name};
+    }
+
+    // Executor shared by all loading, rendering and writing stages.
+    [[nodiscard]] vrdi::thread_pool& pool()
+    {
+        static vrdi::thread_pool instance{
+            settings::jobs != 0 ? settings::jobs
+                                : std::thread::hardware_concurrency()};
+
+        return instance;
+    }
+
     namespace impl
     {
-        [[nodiscard]] std::string html_from_md(const ssvufs::Path& p)
+        // Identifies the Markdown toolchain, so that cached fragments are
+        // invalidated when it changes.
+        [[nodiscard]] const std::string& md_backend_version()
+        {
+            static const std::string version = []
+            {
+                if(settings::md_backend == settings::markdown_backend::pandoc)
+                {
+                    return constant::cache::format_version + " pandoc " +
+                           read_cmd_output("pandoc --version") + " pp " +
+                           read_cmd_output("/usr/local/bin/pp -v");
+                }
+
+                return constant::cache::format_version + " discount " +
+                       std::string{markdown_version};
+            }();
+
+            return version;
+        }
+
+        [[nodiscard]] std::string html_from_md_pandoc(const ssvufs::Path& p)
         {
             static std::mutex mtx;
             static int tempIdx = 0;
@@ -185,53 +364,277 @@ namespace utils
                 utils::exec_cmd(oss.str());
             }
 
-            // TODO: nasty hack: find "resources/" and replace with
-            // "/resources/" for `pp` diagram generation
-            // TODO: consider special variable such as "$RESOURCES"?
-
             std::ifstream ifs{tempf + tempName};
-            return ssvu::getReplacedAll(
-                std::string{std::istreambuf_iterator<char>(ifs),
-                    std::istreambuf_iterator<char>()},
-                "=\"resources/", "=\"/resources/");
-            ;
+            return std::string{std::istreambuf_iterator<char>(ifs),
+                std::istreambuf_iterator<char>()};
+        }
+
+        [[nodiscard]] std::string html_from_md_discount(const std::string& md)
+        {
+            // No `MKD_LATEX`: it would keep escaped brackets such as `\[&\]`
+            // as math. `$` math passes through as text for `convert_math`.
+            // Keep in sync with `test/math_brackets.cpp`.
+            constexpr mkd_flag_t flags = MKD_FENCEDCODE | MKD_GITHUBTAGS |
+                                         MKD_EXTRA_FOOTNOTE | MKD_TOC |
+                                         MKD_IDANCHOR;
+
+            // `discount` lazily initializes global tag tables on the first
+            // compilation, which is not thread-safe.
+            static std::once_flag init_flag;
+            std::call_once(init_flag,
+                []
+                {
+                    MMIOT* doc = mkd_string("", 0, flags);
+                    mkd_compile(doc, flags);
+                    mkd_cleanup(doc);
+                });
+
+            MMIOT* doc =
+                mkd_string(md.data(), static_cast<int>(md.size()), flags);
+
+            if(doc == nullptr)
+            {
+                return {};
+            }
+
+            std::string result;
+
+            if(mkd_compile(doc, flags))
+            {
+                char* html;
+                const int size = mkd_document(doc, &html);
+
+                if(size > 0)
+                {
+                    result.assign(html, static_cast<sz_t>(size));
+                }
+            }
+
+            mkd_cleanup(doc);
+            return result;
+        }
+
+        // Highlights one code block, reusing the result of any previous
+        // build for the same code.
+        [[nodiscard]] std::string highlight_cached(
+            const vrdi::language& l, std::string_view escaped_code)
+        {
+            const std::uint64_t key =
+                vrdi::hasher{}(vrdi::highlighter_version)(l._names.front())(
+                    escaped_code)
+                    .digest();
+
+            if(auto cached = cache().load_fragment(key))
+            {
+                return std::move(*cached);
+            }
+
+            const auto scope = profile("highlight", l._names.front());
+
+            std::string html =
+                vrdi::highlight(l, vrdi::unescape_html(escaped_code));
+
+            cache().store_fragment(key, html);
+            return html;
+        }
+
+        // Replaces the fenced code blocks of rendered Markdown with
+        // highlighted ones, one pool task per block.
+        [[nodiscard]] std::string highlight_code_blocks(std::string html)
+        {
+            const std::vector<vrdi::code_block> blocks =
+                vrdi::find_code_blocks(html);
+
+            if(blocks.empty())
+            {
+                return html;
+            }
+
+            std::vector<std::string> highlighted(blocks.size());
+            vrdi::task_group todo{pool()};
+
+            for(sz_t i = 0; i < blocks.size(); ++i)
+            {
+                todo.run(
+                    [&html, &blocks, &highlighted, i]
+                    {
+                        const vrdi::code_block& b = blocks[i];
+
+                        highlighted[i] = highlight_cached(*b._language,
+                            std::string_view{html}.substr(
+                                b._begin, b._end - b._begin));
+                    });
+            }
+
+            todo.wait();
+            return vrdi::replace_code_blocks(html, blocks, highlighted);
+        }
+
+        // Converts the math of rendered Markdown to MathML, reusing the
+        // result of any previous build for the same expression.
+        [[nodiscard]] std::string convert_math(std::string_view html)
+        {
+            return vrdi::convert_math(html,
+                [](const std::string& tex, bool display)
+                {
+                    const std::uint64_t key =
+                        vrdi::hasher{}(vrdi::mathml_version)(
+                            std::uint64_t{display})(tex)
+                            .digest();
+
+                    if(auto cached = cache().load_fragment(key))
+                    {
+                        return std::move(*cached);
+                    }
+
+                    // Unsupported expressions are cached as empty strings.
+                    std::string mathml =
+                        vrdi::tex_to_mathml(tex, display).value_or("");
+
+                    cache().store_fragment(key, mathml);
+                    return mathml;
+                });
+        }
+
+        // Rendered fragments are cached after a first line holding their
+        // excerpt boundary, which is empty if there is none.
+        [[nodiscard]] std::optional<vrdi::rewritten_html> load_rendered(
+            std::uint64_t key)
+        {
+            std::optional<std::string> cached = cache().load_fragment(key);
+
+            const auto newline =
+                cached ? cached->find('\n') : std::string::npos;
+
+            if(newline == std::string::npos)
+            {
+                return std::nullopt;
+            }
+
+            vrdi::rewritten_html result;
+
+            if(newline != 0)
+            {
+                // A corrupt boundary is a cache miss.
+                const char* begin = cached->data();
+                const auto [end, ec] = std::from_chars(
+                    begin, begin + newline, result._excerpt_end);
+
+                if(ec != std::errc{} || end != begin + newline ||
+                    result._excerpt_end > cached->size() - newline - 1)
+                {
+                    return std::nullopt;
+                }
+            }
+
+            cached->erase(0, newline + 1);
+            result._html = std::move(*cached);
+
+            return result;
         }
 
-        template <typename T>
-        [[nodiscard]] std::string expand_kv_pair(
-            const ssvufs::Path& working_directory, const T& p)
+        void store_rendered(std::uint64_t key, const vrdi::rewritten_html& r)
         {
-            if(ssvu::endsWith(p, ".md"))
+            std::string x;
+            x.reserve(r._html.size() + 24);
+
+            if(r._excerpt_end != std::string::npos)
             {
-                const ssvufs::Path md_path =
-                    working_directory + ssvufs::Path{p};
+                x += std::to_string(r._excerpt_end);
+            }
+
+            x += '\n';
+            x += r._html;
+
+            cache().store_fragment(key, x);
+        }
+
+        [[nodiscard]] vrdi::rewritten_html html_from_md(const ssvufs::Path& p)
+        {
+            const auto scope = profile("markdown", p.getStr());
+            const std::string md = p.getContentsAsStr();
+
+            const std::uint64_t key =
+                vrdi::hasher{}(md_backend_version())(vrdi::highlighter_version)(
+                    vrdi::mathml_version)(md)
+                    .digest();
 
-                return html_from_md(md_path);
+            if(auto cached = load_rendered(key))
+            {
+                lo_verbose("html_from_md") << "cache hit '" << p << "'\n";
+                return std::move(*cached);
             }
 
-            return p;
+            // `pandoc` highlights code blocks itself.
+            std::string html =
+                settings::md_backend == settings::markdown_backend::pandoc
+                    ? html_from_md_pandoc(p)
+                    : highlight_code_blocks(html_from_md_discount(md));
+
+            html = convert_math(html);
+
+            // Rebases "resources/" URLs (e.g. `pp` diagrams) to "/resources/",
+            // and finds the excerpt boundary, in the same pass.
+            vrdi::rewritten_html result = vrdi::rewrite_html(html);
+
+            store_rendered(key, result);
+            return result;
         }
     } // namespace impl
 
-    [[nodiscard]] ssvu::TemplateSystem::Dictionary expand_to_dictionary(
-        const ssvufs::Path& working_directory, const ssvj::Val& mVal)
+    // Offset of the excerpt boundary of each rendered Markdown value, by key.
+    using excerpt_map = std::map<std::string, std::size_t>;
+
+    // If `excerpt_ends` is not null, it receives the excerpt boundaries of the
+    // top-level Markdown values.
+    [[nodiscard]] vrdi::dictionary expand_to_dictionary(
+        const ssvufs::Path& working_directory, const ssvj::Val& mVal,
+        excerpt_map* excerpt_ends = nullptr)
     {
         using namespace ssvj;
 
-        ssvu::TemplateSystem::Dictionary result;
+        vrdi::dictionary result;
 
         for(const auto& p : mVal.forObj())
         {
             if(p.value.is<Str>())
             {
                 const Str& o = p.value.as<Str>();
-                result[p.key] = impl::expand_kv_pair(working_directory, o);
+
+                if(!ssvu::endsWith(o, ".md"))
+                {
+                    if(excerpt_ends != nullptr)
+                    {
+                        // Inline HTML is kept as is: only its excerpt
+                        // boundary is needed.
+                        vrdi::html_rewrite_options excerpt_only;
+                        excerpt_only._rebase_from = {};
+                        excerpt_only._heading_anchors = false;
+                        excerpt_only._lazy_images = false;
+
+                        (*excerpt_ends)[p.key] =
+                            vrdi::rewrite_html(o, excerpt_only)._excerpt_end;
+                    }
+
+                    result[p.key] = o;
+                    continue;
+                }
+
+                vrdi::rewritten_html r = impl::html_from_md(
+                    working_directory + ssvufs::Path{o});
+
+                if(excerpt_ends != nullptr)
+                {
+                    (*excerpt_ends)[p.key] = r._excerpt_end;
+                }
+
+                result[p.key] = std::move(r._html);
             }
             else if(p.value.is<std::vector<Val>>())
             {
                 for(auto x : p.value.as<std::vector<Val>>())
                 {
-                    const ssvu::TemplateSystem::Dictionary inner =
+                    const vrdi::dictionary inner =
                         expand_to_dictionary(working_directory, x);
 
                     result[p.key] += inner;
@@ -242,19 +645,62 @@ namespace utils
         return result;
     }
 
-    void write_to_file(const ssvufs::Path& p, const std::string& s)
+    // Latest modification time of an element's JSON file and of the
+    // markdown files its expansion refers to.
+    void max_source_mtime(const ssvufs::Path& working_directory,
+        const ssvj::Val& mVal, std::time_t& result)
     {
-        const ssvufs::Path p_parent = p.getParent();
-        if(!p_parent.exists<ssvufs::Type::Folder>())
+        using namespace ssvj;
+
+        for(const auto& p : mVal.forObj())
         {
-            exec_cmd("mkdir -p "s + p_parent.getStr());
+            if(p.value.is<Str>())
+            {
+                const Str& o = p.value.as<Str>();
+
+                if(ssvu::endsWith(o, ".md"))
+                {
+                    const ssvufs::Path md_path =
+                        working_directory + ssvufs::Path{o};
+
+                    result = std::max(
+                        result, vrdi::last_write_unix_time(md_path.getStr()));
+                }
+            }
+            else if(p.value.is<std::vector<Val>>())
+            {
+                for(const auto& x : p.value.as<std::vector<Val>>())
+                {
+                    max_source_mtime(working_directory, x, result);
+                }
+            }
         }
+    }
+
+    // Sink for all generated files. Writes are batched and performed in
+    // parallel: call `flush` before relying on them being on disk.
+    [[nodiscard]] vrdi::output_sink& output()
+    {
+        static vrdi::output_sink instance{pool(), settings::skip_unchanged,
+            cache().enabled() ? constant::folder::path::cache + "outputs"
+                              : std::string{}};
+
+        return instance;
+    }
+
+    // Precompressed `.gz`/`.br`/`.zst` sidecars for the result folder.
+    [[nodiscard]] vrdi::sidecar_compressor& sidecars()
+    {
+        static vrdi::sidecar_compressor instance{pool(),
+            cache().enabled() ? constant::folder::path::cache + "sidecars"
+                              : std::string{}};
 
-        assert(p_parent.exists<ssvufs::Type::Folder>());
+        return instance;
+    }
 
-        std::ofstream o{p};
-        o << s;
-        o.flush();
+    void write_to_file(const ssvufs::Path& p, std::string s)
+    {
+        output().write(p.getStr(), std::move(s));
     }
 
     template <typename TF>
@@ -281,18 +727,56 @@ namespace utils
         }
     }
 
+    // Compiled templates, loaded once per build and shared between threads.
+    [[nodiscard]] vrdi::template_registry& templates()
+    {
+        static vrdi::template_registry instance;
+        return instance;
+    }
+
     [[nodiscard]] std::string expand_to_str(
-        ssvu::TemplateSystem::Dictionary& d, const std::string& p)
+        const vrdi::dictionary& d, const std::string& p)
     {
-        static std::map<std::string, std::string> memoized_templates;
+        const auto scope = profile("template", p);
+        return templates().get(p)->expand(d);
+    }
+
+    // Hash of the inputs every page depends on: the shared templates, the
+    // main menu and the versions of the Markdown toolchain, the highlighter
+    // and the MathML converter.
+    [[nodiscard]] std::uint64_t shared_source_hash()
+    {
+        vrdi::hasher h;
+        h(impl::md_backend_version())(vrdi::highlighter_version)(
+            vrdi::mathml_version);
+
+        for(const std::string& t : constant::template_path::shared)
+        {
+            h(t)(vrdi::read_file(t));
+        }
+
+        h(vrdi::read_file(
+            constant::folder::path::content + constant::file::main_menu_json));
+
+        return h.digest();
+    }
+
+    // Hash of every input a page's outputs depend on: the shared inputs, all
+    // files in the page's folder (JSON, Markdown, ...) and the templates used
+    // by its entries and asides.
+    [[nodiscard]] std::uint64_t page_source_hash(std::uint64_t shared_hash,
+        const ssvufs::Path& page_json, const std::set<std::string>& templates)
+    {
+        vrdi::hasher h;
+        h(shared_hash);
+        vrdi::hash_tree(h, page_json.getParent().getStr());
 
-        if(memoized_templates.count(p) == 0)
+        for(const std::string& t : templates)
         {
-            memoized_templates[p] = ssvufs::Path{p}.getContentsAsStr();
+            h(t)(vrdi::read_file(t));
         }
 
-        return d.getExpanded(memoized_templates[p],
-            ssvu::TemplateSystem::Settings::EraseUnexisting);
+        return h.digest();
     }
 
     template <typename T>
@@ -324,7 +808,9 @@ namespace archetype
             // in an `std::string` and slices in `string_view`
 
             ssvufs::Path _template_path;
-            ssvu::TemplateSystem::Dictionary _expand;
+            // Immutable after loading: renders layer their own keys on top
+            // of it, instead of copying it.
+            std::shared_ptr<const vrdi::dictionary> _expand;
             ssvufs::Path _output_path;
             page_id _parent_page;
         };
@@ -336,8 +822,40 @@ namespace archetype
 
     struct entry : public impl::element
     {
+        // Parsed from the "Date" expansion value, if present and valid.
+        std::optional<vrdi::date> _date;
+
+        // Latest modification time of the entry's sources, as Unix time.
+        std::time_t _source_mtime{0};
+
+        // Offset in the rendered "Text" past which listings and feed
+        // summaries cut the entry, or `npos` if it is shown whole.
+        std::size_t _excerpt_end{std::string::npos};
+
         std::optional<std::string> _link_name;
         std::vector<std::string> _tags;
+
+        struct render_cache
+        {
+            std::once_flag _body_once;
+            vrdi::prerendered_template _body;
+
+            std::once_flag _listing_once;
+            std::string _listing;
+        };
+
+        // Expanded on first use, see `entry_body` and `listing_fragment`.
+        std::shared_ptr<render_cache> _rendered =
+            std::make_shared<render_cache>();
+    };
+
+    struct feed
+    {
+        // Only the newest entries are included.
+        sz_t _max_items{20};
+
+        // Include whole entry bodies, instead of the listing excerpt.
+        bool _full_content{true};
     };
 
     struct page
@@ -349,9 +867,23 @@ namespace archetype
         std::string _full_name;
         ssvufs::Path _output_path;
         std::optional<sz_t> _subpaging;
-        std::optional<std::string> _rss;
+        std::optional<feed> _feed;
+        std::uint64_t _source_hash{0};
         std::vector<std::pair<int, entry_id>> _entries;
         std::vector<aside_id> _asides;
+
+        // Templates used by the page's entries and asides.
+        std::set<std::string> _templates;
+
+        struct asides_cache
+        {
+            std::once_flag _once;
+            std::vector<std::string> _expanded;
+        };
+
+        // Expanded on first use, see `expanded_asides`.
+        std::shared_ptr<asides_cache> _expanded_asides =
+            std::make_shared<asides_cache>();
     };
 } // namespace archetype
 
@@ -359,60 +891,44 @@ namespace structure
 {
     namespace impl
     {
+        // Archetypes are stored in a lock-free, append-only slab indexed
+        // directly by their dense ID: lookups are O(1) and never contend.
         template <typename TID, typename TArchetype>
         class mapping
         {
         private:
-            mutable std::mutex _mtx;
-            std::map<TID, TArchetype> _archetypes;
-            TID _next_id{0};
+            vrdi::append_only_slab<TArchetype> _archetypes;
 
         public:
             template <typename TF>
             void create(TF&& f)
             {
-                TID id;
-                TArchetype* slot;
-
-                {
-                    std::scoped_lock lock{_mtx};
-
-                    id = _next_id;
-                    slot = &_archetypes[_next_id];
-
-                    ++_next_id;
-                }
-
-                f(id, *slot);
+                _archetypes.create([&f](sz_t index, TArchetype& slot)
+                    { f(TID{index}, slot); });
             }
 
             [[nodiscard]] const TArchetype& get(TID id) const
             {
-                std::scoped_lock lock{_mtx};
+                return _archetypes.get(static_cast<sz_t>(id));
+            }
 
-                return _archetypes.at(id);
+            [[nodiscard]] sz_t size() const noexcept
+            {
+                return _archetypes.size();
             }
 
             template <typename TF>
             void for_all(TF&& f)
             {
-                std::scoped_lock lock{_mtx};
-
-                for(auto& [k, v] : _archetypes)
-                {
-                    f(k, v);
-                }
+                _archetypes.for_all(
+                    [&f](sz_t index, TArchetype& a) { f(TID{index}, a); });
             }
 
             template <typename TF>
             void for_all(TF&& f) const
             {
-                std::scoped_lock lock{_mtx};
-
-                for(const auto& [k, v] : _archetypes)
-                {
-                    f(k, v);
-                }
+                _archetypes.for_all([&f](sz_t index, const TArchetype& a)
+                    { f(TID{index}, a); });
             }
         };
     } // namespace impl
@@ -423,7 +939,7 @@ namespace structure
 } // namespace structure
 
 using namespace ssvu::FileSystem;
-using namespace ssvu::TemplateSystem;
+using vrdi::dictionary;
 using namespace ssvu::Json;
 
 template <typename TF>
@@ -432,9 +948,14 @@ void for_all_page_json_files(TF&& f)
     lo_verbose("for_all_page_json_files")
         << "scanning directory '" << constant::folder::path::pages << "'\n";
 
-    const std::vector<Path> page_json_paths{
-        getScan<Mode::Recurse, Type::File, Pick::ByName>(
-            constant::folder::path::pages, constant::file::page_json)};
+    const std::vector<Path> page_json_paths = []
+    {
+        const auto scope =
+            utils::profile("scan", constant::folder::path::pages);
+
+        return getScan<Mode::Recurse, Type::File, Pick::ByName>(
+            constant::folder::path::pages, constant::file::page_json);
+    }();
 
     for(const ssvufs::Path& p : page_json_paths)
     {
@@ -454,7 +975,12 @@ void for_all_page_json_files(TF&& f)
         lo_verbose("for_all_page_json_files")
             << "full_name '" << full_name << "'\n";
 
-        const ssvj::Val& json_val = ssvj::fromFile(path);
+        const ssvj::Val json_val = [&path]
+        {
+            const auto scope = utils::profile("json", path.getStr());
+            return ssvj::fromFile(path);
+        }();
+
         f(path, name, full_name, json_val);
     }
 }
@@ -478,9 +1004,14 @@ namespace impl
         lo_verbose("for_all_page_element_files")
             << "scanning directory '" << elements_path << "'\n";
 
-        const std::vector<Path> json_files{
-            getScan<Mode::Recurse, Type::File, Pick::ByExt>(
-                elements_path, ".json")};
+        const std::vector<Path> json_files = [&elements_path]
+        {
+            const auto scope =
+                utils::profile("scan", elements_path.getStr());
+
+            return getScan<Mode::Recurse, Type::File, Pick::ByExt>(
+                elements_path, ".json");
+        }();
 
         for(const ssvufs::Path& path : json_files)
         {
@@ -494,7 +1025,12 @@ namespace impl
                 "");
 
             // Read json contents.
-            const ssvj::Val& json_val = ssvj::fromFile(path);
+            const ssvj::Val json_val = [&path]
+            {
+                const auto scope = utils::profile("json", path.getStr());
+                return ssvj::fromFile(path);
+            }();
+
             f(path, name, full_name, json_val);
         }
     }
@@ -548,103 +1084,52 @@ void for_all_asides(const ssvufs::Path& page_path, TF&& f)
     impl::for_all_elements(constant::folder::name::asides, page_path, FWD(f));
 }
 
-[[nodiscard]] std::string escape_xml(const std::string& x)
-{
-    std::string s;
-    s.reserve(x.size() * 1.4f);
-
-    for(std::size_t i = 0; i != x.size(); ++i)
-    {
-        switch(x[i])
-        {
-            case '&': s.append("&amp;"); break;
-            case '\"': s.append("&quot;"); break;
-            case '\'': s.append("&apos;"); break;
-            case '<': s.append("&lt;"); break;
-            case '>': s.append("&gt;"); break;
-            case '`': break;
-            default: s.append(&x[i], 1); break;
-        }
-    }
-
-    return s;
-}
-
 struct context
 {
     structure::aside_mapping _aside_mapping;
     structure::entry_mapping _entry_mapping;
     structure::page_mapping _page_mapping;
 
-    // TODO: already expanded menu
     archetype::main_menu _main_menu;
 
+    // Hash of the inputs shared by all pages, see `utils::shared_source_hash`.
+    std::uint64_t _shared_source_hash{0};
+
+    // Expanded once per build and shared by every output page.
+    std::string _expanded_main_menu;
+    vrdi::prerendered_template _page_chrome;
+
+    // Only included in pages with math that was not converted to MathML.
+    std::string _expanded_mathjax;
+
+    // Entries and asides left unreferenced by page reloads. They stay in
+    // their mappings until the context is reloaded as a whole.
+    sz_t _stale_archetypes{0};
+
     // structure::page_hierarchy _page_hierarchy;
 };
 
 struct subpage_expansion
 {
     std::vector<std::string> _expanded_entries;
-    std::vector<entry_id> _expanded_entry_ids;
     std::string _link;
 
-    void write_rss_feed(
-        bool first, const context& ctx, const archetype::page& ap) const
-    {
-        if(!ap._rss)
-        {
-            return;
-        }
-
-        const std::string feed_output_path = ssvu::getReplaced(
-            first ? ap._output_path : Path{_link}, ".html", ".rss");
-
-        Dictionary d;
-        d["FeedLink"] = utils::result_to_website(feed_output_path);
-
-        for(const auto& ei : _expanded_entry_ids)
-        {
-            const archetype::entry& ae = ctx._entry_mapping.get(ei);
-            const auto& aee = ae._expand;
-            if(!ae._link_name) continue;
-
-            if(!aee.has("Title") || !aee.has("Date"))
-            {
-                continue;
-            }
-
-            Dictionary d_item;
-            d_item["Title"] = escape_xml(aee["Title"].asStr());
-            d_item["Link"] = utils::result_to_website(ae._output_path);
-            d_item["Date"] = aee["Date"].asStr();
-            d_item["Description"] = escape_xml(aee["Title"].asStr());
-            d_item["PubDate"] = utils::to_pubdate(d_item["Date"].asStr());
-
-            d["Items"] += d_item;
-        }
-
-        const std::string res =
-            utils::expand_to_str(d, "templates/other/rss.tpl");
-
-        utils::write_to_file(feed_output_path, res);
-    }
-
     [[nodiscard]] std::string produce_expanded_main(const archetype::page& ap,
         const std::vector<subpage_expansion>& subpages,
         const std::vector<std::string>& expanded_asides) const
     {
-        Dictionary d_main;
+        dictionary d_main;
 
         // Add expanded entries.
         for(const std::string& e : _expanded_entries)
         {
-            d_main["Entries"] += Dictionary{"Entry", e};
+            d_main["Entries"] += dictionary{"Entry", e};
         }
 
         // Add expanded asides.
         for(const std::string& a : expanded_asides)
         {
-            d_main["Asides"] += Dictionary{"Aside", a};
+            d_main["Asides"] += dictionary{"Aside", a};
         }
 
         // Add pagination controls.
@@ -653,7 +1138,7 @@ struct subpage_expansion
             sz_t page_idx = 0;
             for(const auto& a : subpages)
             {
-                Dictionary inner_dict;
+                dictionary inner_dict;
 
                 inner_dict["Subpage"] =
                     ssvu::getReplaced(a._link, "result/", "/");
@@ -666,59 +1151,59 @@ struct subpage_expansion
             }
         }
 
-        return utils::expand_to_str(d_main, "templates/base/main.tpl");
-    }
-
-    [[nodiscard]] std::string produce_expanded_main_menu(
-        const context& ctx) const
-    {
-        Dictionary d_mainmenu;
-
-        for(const auto& mm_e : ctx._main_menu._menu_entries)
-        {
-            Dictionary d_button;
-            d_button["Link"] = mm_e._href;
-            d_button["Title"] = mm_e._label;
-
-            d_mainmenu["MenuItems"] += d_button;
-        }
-
-        return utils::expand_to_str(d_mainmenu, "templates/base/mainMenu.tpl");
+        return utils::expand_to_str(d_main, constant::template_path::main);
     }
 
     [[nodiscard]] std::string produce_expanded_page(
-        const std::string& expanded_main,
-        const std::string& expanded_main_menu) const
+        const context& ctx, const std::string& expanded_main) const
     {
-        Dictionary d_page;
-        d_page["Main"] = expanded_main;
-        d_page["MainMenu"] = expanded_main_menu;
-        d_page["ResourcesPath"] = constant::folder::path::resources;
+        // Math is converted to MathML at build time: the MathJax runtime is
+        // only needed for expressions the converter does not support.
+        const std::string_view mathjax =
+            vrdi::has_unconverted_math(expanded_main) ? ctx._expanded_mathjax
+                                                      : std::string_view{};
 
-        return utils::expand_to_str(d_page, "templates/page.tpl");
+        return ctx._page_chrome.fill({expanded_main, mathjax});
     }
 
-    [[nodiscard]] std::string produce_result(bool first, const context& ctx,
+    [[nodiscard]] std::string produce_result(const context& ctx,
         const archetype::page& ap,
-        const std::vector<subpage_expansion>& subpages, const Path& output_path,
+        const std::vector<subpage_expansion>& subpages,
         const std::vector<std::string>& expanded_asides) const
     {
-        (void)output_path;
-
-        write_rss_feed(first, ctx, ap);
-
         auto expanded_main =
             produce_expanded_main(ap, subpages, expanded_asides);
 
-        auto expanded_main_menu = produce_expanded_main_menu(ctx);
-
-        return produce_expanded_page(expanded_main, expanded_main_menu);
+        return produce_expanded_page(ctx, expanded_main);
     }
 };
 
+// Asides of a page, expanded once per build and shared by all of its
+// subpages and permalinks.
+[[nodiscard]] const std::vector<std::string>& expanded_asides(
+    const context& ctx, const archetype::page& ap)
+{
+    archetype::page::asides_cache& c = *ap._expanded_asides;
+
+    std::call_once(c._once,
+        [&]
+        {
+            c._expanded.reserve(ap._asides.size());
+
+            for(const aside_id aid : ap._asides)
+            {
+                const archetype::aside& aa = ctx._aside_mapping.get(aid);
+
+                c._expanded.emplace_back(
+                    utils::expand_to_str(*aa._expand, aa._template_path));
+            }
+        });
+
+    return c._expanded;
+}
+
 struct page_expansion
 {
-    std::vector<std::string> _expanded_asides;
     std::vector<subpage_expansion> _subpages;
 
     auto produce_result(
@@ -726,14 +1211,7 @@ struct page_expansion
     {
         assert(_subpages.size() > 0);
 
-        // Generate asides
-        for(const aside_id aid : ap._asides)
-        {
-            archetype::aside aa = ctx._aside_mapping.get(aid);
-
-            _expanded_asides.emplace_back(
-                utils::expand_to_str(aa._expand, aa._template_path));
-        }
+        const std::vector<std::string>& asides = expanded_asides(ctx, ap);
 
         // Set links
         subpage_expansion& first_subpage = _subpages[0];
@@ -750,20 +1228,22 @@ struct page_expansion
         }
 
         // ---
-        // Write to file
-        const std::string first_subpage_html = first_subpage.produce_result(
-            true, ctx, ap, _subpages, output_path, _expanded_asides);
-
-        utils::write_to_file(output_path, first_subpage_html);
+        // Write to file (subpages are independent of each other)
+        vrdi::task_group todo{utils::pool()};
 
-        for(sz_t i = 1; i < _subpages.size(); ++i)
+        for(sz_t i = 0; i < _subpages.size(); ++i)
         {
-            const auto& s = _subpages[i];
+            todo.run(
+                [this, &ctx, &ap, &asides, i]
+                {
+                    const auto& s = _subpages[i];
 
-            utils::write_to_file(
-                s._link, s.produce_result(false, ctx, ap, _subpages,
-                             Path{s._link}, _expanded_asides));
+                    utils::write_to_file(
+                        s._link, s.produce_result(ctx, ap, _subpages, asides));
+                });
         }
+
+        todo.wait();
     }
 };
 
@@ -771,7 +1251,7 @@ void process_page_entries(context& ctx, const Path& output_path,
     const Path& path, page_id pid, archetype::page& ap)
 {
     int ordering = 0;
-    std::vector<std::future<void>> todo;
+    vrdi::task_group todo{utils::pool()};
 
     for_all_entries(path,
         [&ordering, &ctx, &output_path, &pid, &ap, &todo](
@@ -796,8 +1276,15 @@ void process_page_entries(context& ctx, const Path& output_path,
                         auto e_template_path = e_contents["template"].as<Str>();
                         auto e_expand_data = e_contents["expand"].as<Val>();
                         auto wd = e_path.getParent();
-                        auto dic =
-                            utils::expand_to_dictionary(wd, e_expand_data);
+                        utils::excerpt_map excerpt_ends;
+                        auto dic = utils::expand_to_dictionary(
+                            wd, e_expand_data, &excerpt_ends);
+
+                        if(const auto it = excerpt_ends.find("Text");
+                            it != excerpt_ends.end())
+                        {
+                            ae._excerpt_end = it->second;
+                        }
 
                         auto e_output_path =
                             Path{ssvu::getReplaced(output_path, ".html", "")} +
@@ -807,6 +1294,7 @@ void process_page_entries(context& ctx, const Path& output_path,
                         {
                             std::scoped_lock lock(*ap._mtx);
                             ap._entries.emplace_back(ordering, eid);
+                            ap._templates.emplace(e_template_path);
                         }
 
 
@@ -835,8 +1323,27 @@ void process_page_entries(context& ctx, const Path& output_path,
                             ae._tags.emplace_back("untagged");
                         }
 
+                        if(const std::string* d = dic.find_value("Date"))
+                        {
+                            ae._date = vrdi::parse_date(*d);
+
+                            if(!ae._date)
+                            {
+                                ssvu::lo("Entry|date")
+                                    << "invalid date '" << *d << "' in '"
+                                    << e_path << "'\n";
+                            }
+                        }
+
+                        ae._source_mtime =
+                            vrdi::last_write_unix_time(e_path.getStr());
+
+                        utils::max_source_mtime(
+                            wd, e_expand_data, ae._source_mtime);
+
                         ae._template_path = e_template_path;
-                        ae._expand = dic;
+                        ae._expand =
+                            std::make_shared<const dictionary>(std::move(dic));
                         ae._output_path = e_output_path;
                         ae._parent_page = pid;
 
@@ -849,8 +1356,10 @@ void process_page_entries(context& ctx, const Path& output_path,
                     });
             };
 
-            todo.emplace_back(std::async(f));
+            todo.run(std::move(f));
         });
+
+    todo.wait();
 }
 
 void process_page_asides(context& ctx, const Path& output_path,
@@ -882,12 +1391,14 @@ void process_page_asides(context& ctx, const Path& output_path,
                     {
                         std::scoped_lock lock(*ap._mtx);
                         ap._asides.emplace_back(aid);
+                        ap._templates.emplace(template_path);
                     }
 
                     aa._parent_page = pid;
                     aa._template_path = template_path;
                     aa._output_path = a_output_path;
-                    aa._expand = dict;
+                    aa._expand =
+                        std::make_shared<const dictionary>(std::move(dict));
 
                     // Increment unique aside id.
                     lo_verbose() << "\n";
@@ -905,8 +1416,56 @@ void clean_and_recreate_result_folder()
         ssvufs::createFolder(rp);
     }
 
-    utils::exec_cmd("rm -R ./"s + rp.getStr() + "*");
-    utils::exec_cmd("ln -s ../resources/ ./" + rp.getStr());
+    namespace fs = std::filesystem;
+    std::error_code ec;
+
+    // Outputs of unchanged pages are kept around for incremental builds.
+    if(settings::clean || !settings::use_cache)
+    {
+        for(const auto& e : fs::directory_iterator{rp.getStr()})
+        {
+            fs::remove_all(e.path(), ec);
+        }
+
+        fs::remove(constant::folder::path::cache + "manifest", ec);
+    }
+
+    const fs::path resources_link{
+        rp.getStr() + constant::folder::name::resources};
+    if(!fs::exists(fs::symlink_status(resources_link)))
+    {
+        fs::create_directory_symlink("../resources", resources_link, ec);
+    }
+}
+
+void report_changed_outputs()
+{
+    const std::vector<std::string> changed =
+        utils::output().take_changed_paths();
+    ssvu::lo("main") << changed.size() << " output(s) changed\n";
+
+    if(!settings::list_changed)
+    {
+        return;
+    }
+
+    for(const std::string& p : changed)
+    {
+        ssvu::lo("changed") << p << "\n";
+    }
+}
+
+// Logs outputs that could not be written. Returns `false` if there were any.
+bool report_failed_outputs()
+{
+    const std::vector<std::string> failures = utils::output().take_failures();
+
+    for(const std::string& f : failures)
+    {
+        ssvu::lo("output") << "write failed: " << f << "\n";
+    }
+
+    return failures.empty();
 }
 
 void load_main_menu_data(context& ctx)
@@ -930,9 +1489,39 @@ void load_main_menu_data(context& ctx)
     };
 }
 
+void expand_shared_chrome(context& ctx)
+{
+    dictionary d_mainmenu;
+
+    for(const auto& mm_e : ctx._main_menu._menu_entries)
+    {
+        dictionary d_button;
+        d_button["Link"] = mm_e._href;
+        d_button["Title"] = mm_e._label;
+
+        d_mainmenu["MenuItems"] += d_button;
+    }
+
+    ctx._expanded_main_menu =
+        utils::expand_to_str(d_mainmenu, constant::template_path::main_menu);
+
+    ctx._expanded_mathjax =
+        utils::expand_to_str(dictionary{}, constant::template_path::mathjax);
+
+    // Everything in `page.tpl` but the main content is the same for all
+    // pages: expand it once, leaving holes for `{{Main}}` and `{{MathJax}}`.
+    dictionary d_page;
+    d_page["MainMenu"] = ctx._expanded_main_menu;
+    d_page["ResourcesPath"] = constant::folder::path::resources;
+
+    ctx._page_chrome = utils::templates()
+                           .get(constant::template_path::page)
+                           ->prerender(d_page, {"Main", "MathJax"});
+}
+
 void load_page_data(context& ctx)
 {
-    std::vector<std::future<void>> todo;
+    vrdi::task_group todo{utils::pool()};
 
     for_all_page_json_files(
         [&ctx, &todo](auto path, auto name, auto full_name, Val contents)
@@ -975,16 +1564,30 @@ void load_page_data(context& ctx)
                         lo_verbose("Page|eps") << eps << "\n";
                     }
 
-                    // Check for RSS options.
+                    // Check for feed options.
                     if(contents.has("rss"))
                     {
+                        const auto& rss = contents["rss"];
+                        archetype::feed f;
+
+                        if(rss.has("max_items"))
+                        {
+                            f._max_items = rss["max_items"].as<IntU>();
+                        }
+
+                        if(rss.has("content"))
+                        {
+                            f._full_content =
+                                rss["content"].as<Str>() != "summary";
+                        }
+
                         {
                             std::scoped_lock lock(*ap._mtx);
-                            ap._rss = contents["rss"]["output"].as<Str>();
+                            ap._feed = f;
                         }
                     }
 
-                    todo.emplace_back(std::async(
+                    todo.run(
                         [&ctx, output_path, path, pid, &ap]
                         {
                             process_page_entries(
@@ -992,38 +1595,96 @@ void load_page_data(context& ctx)
 
                             process_page_asides(
                                 ctx, output_path, path, pid, ap);
-                        }));
+                        });
                 });
         });
+
+    todo.wait();
+}
+
+void hash_page_source(const context& ctx, archetype::page& ap)
+{
+    std::scoped_lock lock(*ap._mtx);
+
+    ap._source_hash = utils::page_source_hash(
+        ctx._shared_source_hash, ap._path, ap._templates);
+}
+
+void hash_page_sources(context& ctx)
+{
+    vrdi::task_group todo{utils::pool()};
+
+    ctx._page_mapping.for_all(
+        [&ctx, &todo](auto, archetype::page& ap)
+        { todo.run([&ctx, &ap] { hash_page_source(ctx, ap); }); });
+
+    todo.wait();
 }
 
-void build_tag_expansion(archetype::entry& ae)
+void build_tag_expansion(const archetype::entry& ae, dictionary& overlay)
 {
     for(const auto& t : ae._tags)
     {
-        Dictionary tag0;
-        tag0["Link"] = "#";
+        dictionary tag0;
+        tag0["Link"] = "/" + constant::folder::name::tags + "/" +
+                       utils::tag_slug(t) + ".html";
         tag0["Label"] = t;
-        ae._expand["Tags"] += tag0;
+        overlay["Tags"] += tag0;
     }
 }
 
+// Entry template expanded once per build, except for the values that differ
+// between its listing and its permalink page.
+[[nodiscard]] const vrdi::prerendered_template& entry_body(
+    const archetype::entry& ae)
+{
+    archetype::entry::render_cache& c = *ae._rendered;
+
+    std::call_once(c._body_once,
+        [&]
+        {
+            const std::string& path = ae._template_path.getStr();
+            const auto scope = utils::profile("template", path);
+
+            dictionary overlay{ae._expand};
+            build_tag_expansion(ae, overlay);
+
+            // In the order of `fill_entry_body`'s values.
+            c._body = utils::templates().get(path)->prerender(overlay,
+                {"Text", "PermalinkBegin", "PermalinkEnd", "CommentsBox"});
+        });
+
+    return c._body;
+}
+
+// Splices the per-render values of `overlay`, layered over the entry's
+// expansion, into its body.
+[[nodiscard]] std::string fill_entry_body(
+    const archetype::entry& ae, const dictionary& overlay)
+{
+    const auto value = [&](const std::string& key)
+    {
+        const std::string* v = overlay.find_value(key);
+        return v != nullptr ? std::string_view{*v} : std::string_view{};
+    };
+
+    return entry_body(ae).fill({value("Text"), value("PermalinkBegin"),
+        value("PermalinkEnd"), value("CommentsBox")});
+}
+
 void process_pages_permalink(
     const context& ctx, const archetype::page& ap, entry_id eid)
 {
-    // Create copy of page archetype for the single-article pages
-    // and disable automatic pagination/RSS
-    auto my_ap = ap;
-    my_ap._subpaging = std::nullopt;
-    my_ap._rss = std::nullopt;
-
-    auto ae = ctx._entry_mapping.get(eid);
+    const archetype::entry& ae = ctx._entry_mapping.get(eid);
     if(!ae._link_name)
     {
         return;
     }
 
+    // Per-render keys, layered over the entry's immutable dictionary.
+    dictionary overlay{ae._expand};
 
+    // Single-article pages have no automatic pagination
     page_expansion permalink_pe;
     permalink_pe._subpages.emplace_back();
     auto& subpage = permalink_pe._subpages.back();
@@ -1034,28 +1695,20 @@ void process_pages_permalink(
 
     // Disqus
     {
-        Dictionary disqus;
+        dictionary disqus;
         disqus["PageUrl"] = canonical_permalink_url;
         disqus["PageId"] = ae._link_name.value();
 
-        auto disqus_template =
-            Path{"templates/other/disqus.tpl"}.getContentsAsStr();
-        auto expanded_disqus =
-            disqus.getExpanded(disqus_template, Settings::EraseUnexisting);
-
-        ae._expand["CommentsBox"] = expanded_disqus;
+        overlay["CommentsBox"] =
+            utils::expand_to_str(disqus, constant::template_path::disqus);
     }
 
-
-
-    build_tag_expansion(ae);
-    auto e_expanded = utils::expand_to_str(ae._expand, ae._template_path);
-
-    subpage._expanded_entries.emplace_back(e_expanded);
-    permalink_pe.produce_result(ctx, my_ap, permalink_output_path);
+    subpage._expanded_entries.emplace_back(fill_entry_body(ae, overlay));
+    permalink_pe.produce_result(ctx, ap, permalink_output_path);
 }
 
-void process_entries_ellipsis_and_permalink(archetype::entry& ae)
+void process_entries_ellipsis_and_permalink(
+    const archetype::entry& ae, dictionary& overlay)
 {
     if(!ae._link_name)
     {
@@ -1063,8 +1716,8 @@ void process_entries_ellipsis_and_permalink(archetype::entry& ae)
         return;
     }
 
-    auto atag_href =
-        ssvu::getReplaced(ae._output_path, constant::folder::path::result, "");
+    auto atag_href = vrdi::escape_html_attribute(
+        ssvu::getReplaced(ae._output_path, constant::folder::path::result, ""));
 
     auto atag_link = "<a href='/" + atag_href + "'>";
 
@@ -1074,103 +1727,1069 @@ void process_entries_ellipsis_and_permalink(archetype::entry& ae)
         atag_href + "'>";
 
     // Ellipse long text
-    std::string old_text = ae._expand["Text"].asStr();
-    auto second_paragraph = utils::find_nth(old_text, 0, "</p>", 2);
-
-    if(second_paragraph != std::string::npos)
+    if(ae._excerpt_end != std::string::npos)
     {
-        auto new_text = old_text.substr(0, second_paragraph + 4);
+        std::string new_text;
+        new_text.reserve(ae._excerpt_end + 192);
+
+        new_text.append(ae._expand->at("Text"), 0, ae._excerpt_end);
         new_text +=
             "<p style='text-align: right; font-style: italic; font-size: small;'> "s +
             atag_link + " ... read more </a></p></body></html>";
 
-        ae._expand["Text"] = new_text;
+        overlay["Text"] = std::move(new_text);
     }
 
-    ae._expand["PermalinkBegin"] = atag_link_styled;
-    ae._expand["PermalinkEnd"] = "</a>";
+    overlay["PermalinkBegin"] = atag_link_styled;
+    overlay["PermalinkEnd"] = "</a>";
 }
 
-void process_pages(context& ctx)
+// Writes the page's RSS and Atom feeds, with the newest entries first. Entry
+// bodies are taken from the already rendered `Text`.
+void write_feeds(const context& ctx, const archetype::page& ap)
 {
-    ctx._page_mapping.for_all(
-        [&ctx](auto, archetype::page& ap)
+    if(!ap._feed)
+    {
+        return;
+    }
+
+    const auto scope = utils::profile("feed", ap._output_path.getStr());
+    const archetype::feed& f = *ap._feed;
+
+    struct item_storage
+    {
+        std::string _link;
+        std::string _rss_date;
+        std::string _atom_date;
+        std::string _summary;
+    };
+
+    // Reserved upfront: `items` points into the stored strings.
+    std::vector<item_storage> storage;
+    storage.reserve(std::min(f._max_items, ap._entries.size()));
+
+    std::vector<vrdi::feed_item> items;
+    items.reserve(storage.capacity());
+
+    for(const auto& [order, eid] : ap._entries)
+    {
+        if(items.size() == f._max_items)
         {
-            std::sort(ap._entries.begin(), ap._entries.end(),
-                [](const auto& e0, const auto& e1)
-                { return e0.first < e1.first; });
+            break;
+        }
 
-            const auto& entry_ids = ap._entries;
-            if(entry_ids.empty())
-            {
-                return;
-            }
+        const archetype::entry& ae = ctx._entry_mapping.get(eid);
+        const dictionary& aee = *ae._expand;
+
+        if(!ae._link_name || !aee.has("Title") || !ae._date)
+        {
+            continue;
+        }
 
-            page_expansion pe;
+        item_storage& st = storage.emplace_back();
+        st._link = utils::result_to_website(ae._output_path);
+        st._rss_date = vrdi::format_rfc822(*ae._date);
+        st._atom_date = vrdi::format_rfc3339(*ae._date);
 
-            // Expand permalinks (single-article pages)
-            for(auto [order, eid] : entry_ids)
+        std::string_view content;
+        if(const std::string* text = aee.find_value("Text"))
+        {
+            content = *text;
+
+            // Summaries stop where listings place their "read more" link.
+            if(!f._full_content && ae._excerpt_end != std::string::npos)
             {
-                process_pages_permalink(ctx, ap, eid);
+                st._summary = text->substr(0, ae._excerpt_end);
+                st._summary +=
+                    "<p><a href='" + st._link + "'>... read more</a></p>";
+
+                content = st._summary;
             }
+        }
 
-            auto make_subpage = [&](auto i_begin, auto i_end)
-            {
-                pe._subpages.emplace_back();
-                auto& subpage = pe._subpages.back();
+        items.push_back(vrdi::feed_item{
+            aee.at("Title"), st._link, st._rss_date, st._atom_date, content});
+    }
 
-                for(sz_t ei(i_begin); ei < i_end; ++ei)
-                {
-                    entry_id eid = entry_ids[ei].second;
-                    auto ae = ctx._entry_mapping.get(eid);
-                    process_entries_ellipsis_and_permalink(ae);
+    const std::string rss_output_path =
+        ssvu::getReplaced(ap._output_path, ".html", ".rss");
+
+    const std::string atom_output_path =
+        ssvu::getReplaced(ap._output_path, ".html", ".atom");
+
+    const std::string rss_link = utils::result_to_website(rss_output_path);
+    const std::string atom_link = utils::result_to_website(atom_output_path);
+
+    // Without items, the feed was last updated with its newest source.
+    std::time_t newest_source = vrdi::last_write_unix_time(ap._path.getStr());
+    for(const auto& [order, eid] : ap._entries)
+    {
+        newest_source = std::max(
+            newest_source, ctx._entry_mapping.get(eid)._source_mtime);
+    }
+
+    const std::string updated = vrdi::format_rfc3339(newest_source);
+
+    vrdi::feed_channel channel{constant::feed::title,
+        constant::feed::description, constant::feed::author,
+        constant::feed::language, constant::url::path::website, rss_link,
+        updated};
+
+    utils::write_to_file(rss_output_path, vrdi::write_rss(channel, items));
+
+    channel._self_link = atom_link;
+    utils::write_to_file(atom_output_path, vrdi::write_atom(channel, items));
+}
+
+// Orders a page's entries by their position in the sources, then reorders
+// the dated ones newest-first among the slots they occupy. Undated entries
+// (headers, menus) keep their place.
+void sort_page_entries(const context& ctx, archetype::page& ap)
+{
+    auto& entries = ap._entries;
+
+    std::sort(entries.begin(), entries.end(),
+        [](const auto& e0, const auto& e1) { return e0.first < e1.first; });
+
+    const auto date_of = [&ctx](const auto& e) -> const auto&
+    { return ctx._entry_mapping.get(e.second)._date; };
+
+    std::vector<sz_t> dated_slots;
+    std::vector<std::pair<int, entry_id>> dated;
+
+    for(sz_t i = 0; i < entries.size(); ++i)
+    {
+        if(date_of(entries[i]))
+        {
+            dated_slots.emplace_back(i);
+            dated.emplace_back(entries[i]);
+        }
+    }
+
+    std::stable_sort(dated.begin(), dated.end(),
+        [&](const auto& e0, const auto& e1)
+        { return *date_of(e1) < *date_of(e0); });
+
+    for(sz_t i = 0; i < dated.size(); ++i)
+    {
+        entries[dated_slots[i]] = dated[i];
+    }
+}
+
+// Listing fragment of an entry (excerpt and permalink around its body),
+// filled once and shared by its page and its tag pages.
+[[nodiscard]] const std::string& listing_fragment(const archetype::entry& ae)
+{
+    archetype::entry::render_cache& c = *ae._rendered;
+
+    std::call_once(c._listing_once,
+        [&]
+        {
+            dictionary overlay{ae._expand};
+            process_entries_ellipsis_and_permalink(ae, overlay);
 
-                    build_tag_expansion(ae);
-                    auto e_expanded =
-                        utils::expand_to_str(ae._expand, ae._template_path);
+            c._listing = fill_entry_body(ae, overlay);
+        });
+
+    return c._listing;
+}
+
+// Splits the page's entries into subpages according to its subpaging
+// options, and fills them with listing fragments in parallel.
+void expand_subpages(
+    const context& ctx, const archetype::page& ap, page_expansion& pe)
+{
+    const auto& entry_ids = ap._entries;
+
+    // Compute subpage ranges
+    std::vector<std::pair<sz_t, sz_t>> ranges;
+
+    if(ap._subpaging)
+    {
+        auto entries_per_subpage = ap._subpaging.value();
+        auto subpage_count =
+            std::max(sz_t(1), entry_ids.size() / entries_per_subpage);
+
+        utils::segmented_for(subpage_count, entries_per_subpage,
+            entry_ids.size(), [&](auto, auto i_begin, auto i_end)
+            { ranges.emplace_back(i_begin, i_end); });
+    }
+    else
+    {
+        ranges.emplace_back(0, entry_ids.size());
+    }
+
+    // Create subpages
+    pe._subpages.resize(ranges.size());
+
+    vrdi::task_group subpages{utils::pool()};
+
+    for(sz_t i = 0; i < ranges.size(); ++i)
+    {
+        subpages.run(
+            [&, i]
+            {
+                for(sz_t ei = ranges[i].first; ei < ranges[i].second; ++ei)
+                {
+                    const archetype::entry& ae =
+                        ctx._entry_mapping.get(entry_ids[ei].second);
 
-                    subpage._expanded_entry_ids.emplace_back(eid);
-                    subpage._expanded_entries.emplace_back(e_expanded);
+                    pe._subpages[i]._expanded_entries.emplace_back(
+                        listing_fragment(ae));
                 }
-            };
+            });
+    }
+
+    subpages.wait();
+}
+
+void process_page(const context& ctx, const archetype::page& ap)
+{
+    const auto& entry_ids = ap._entries;
+    if(entry_ids.empty())
+    {
+        return;
+    }
+
+    const auto scope = utils::profile("page", ap._full_name);
+    utils::cache().record_page(ap._full_name, ap._source_hash);
+
+    // Skip pages whose inputs did not change since the last build.
+    if(utils::cache().is_page_fresh(ap._full_name, ap._source_hash) &&
+        Path{ap._output_path}.exists<Type::File>())
+    {
+        lo_verbose("process_pages")
+            << "skipping unchanged page '" << ap._full_name << "'\n";
 
-            // Create subpages
-            if(ap._subpaging)
+        return;
+    }
+
+    // Expand permalinks (single-article pages) in the background
+    vrdi::task_group permalinks{utils::pool()};
+
+    for(auto [order, eid] : entry_ids)
+    {
+        permalinks.run(
+            [&ctx, &ap, eid = eid] { process_pages_permalink(ctx, ap, eid); });
+    }
+
+    page_expansion pe;
+    expand_subpages(ctx, ap, pe);
+
+    pe.produce_result(ctx, ap, ap._output_path);
+    write_feeds(ctx, ap);
+    permalinks.wait();
+}
+
+// Tag -> entries with a permalink, newest first. Built in one pass over
+// all pages.
+using tag_index = std::map<std::string, std::vector<std::pair<int, entry_id>>>;
+
+// Tags whose slugs collide would overwrite each other's pages, so they are
+// left out. If `collisions` is not null, it receives a description of each
+// collision.
+[[nodiscard]] tag_index build_tag_index(
+    const context& ctx, std::vector<std::string>* collisions = nullptr)
+{
+    std::vector<std::pair<const archetype::entry*, entry_id>> entries;
+
+    ctx._page_mapping.for_all(
+        [&](auto, const archetype::page& ap)
+        {
+            for(const auto& [order, eid] : ap._entries)
             {
-                auto entries_per_subpage = ap._subpaging.value();
-                auto subpage_count =
-                    std::max(sz_t(1), entry_ids.size() / entries_per_subpage);
-
-                utils::segmented_for(subpage_count, entries_per_subpage,
-                    entry_ids.size(),
-                    [&](auto, auto i_begin, auto i_end)
-                    { make_subpage(i_begin, i_end); });
+                const archetype::entry& ae = ctx._entry_mapping.get(eid);
+
+                if(ae._link_name)
+                {
+                    entries.emplace_back(&ae, eid);
+                }
             }
-            else
+        });
+
+    // Newest first; undated entries last. Ties are broken by output path,
+    // so that the order does not depend on page loading order.
+    std::sort(entries.begin(), entries.end(),
+        [](const auto& e0, const auto& e1)
+        {
+            const archetype::entry& a = *e0.first;
+            const archetype::entry& b = *e1.first;
+
+            if(a._date != b._date)
             {
-                make_subpage(0, entry_ids.size());
+                return !b._date || (a._date && *b._date < *a._date);
             }
 
-            pe.produce_result(ctx, ap, ap._output_path);
+            return a._output_path.getStr() < b._output_path.getStr();
         });
-}
 
-int main()
-{
-    lo_verbose("main") << "cleaning and re-creating result folder\n";
-    clean_and_recreate_result_folder();
-
-    context ctx;
+    tag_index result;
 
-    lo_verbose("main") << "loading main menu data\n";
-    load_main_menu_data(ctx);
+    for(int i = 0; i < static_cast<int>(entries.size()); ++i)
+    {
+        for(const std::string& t : entries[i].first->_tags)
+        {
+            result[t].emplace_back(i, entries[i].second);
+        }
+    }
 
-    lo_verbose("main") << "loading page data\n";
-    load_page_data(ctx);
+    std::map<std::string, std::vector<std::string>> tags_by_slug;
+    for(const auto& p : result)
+    {
+        tags_by_slug[utils::tag_slug(p.first)].emplace_back(p.first);
+    }
 
-    lo_verbose("main") << "processing pages\n";
-    process_pages(ctx);
+    for(const auto& [slug, tags] : tags_by_slug)
+    {
+        if(tags.size() < 2)
+        {
+            continue;
+        }
+
+        std::string description = "tags";
+        for(const std::string& t : tags)
+        {
+            description += " '" + t + "'";
+            result.erase(t);
+        }
+
+        if(collisions != nullptr)
+        {
+            collisions->emplace_back(
+                description + " share the page 'tags/" + slug + ".html'");
+        }
+    }
+
+    return result;
+}
+
+// Paginated listing of the entries with tag `t`, with its own feeds.
+void process_tag_page(const context& ctx, const std::string& t,
+    const std::vector<std::pair<int, entry_id>>& entries)
+{
+    archetype::page tp;
+    tp._name = tp._full_name = constant::folder::name::tags + "/" + t;
+    tp._output_path =
+        constant::folder::path::tags + utils::tag_slug(t) + ".html";
+    tp._subpaging = constant::tags::entries_per_subpage;
+    tp._feed = archetype::feed{constant::tags::feed_items, false};
+    tp._entries = entries;
+
+    const std::string feed_link = "/" + constant::folder::name::tags + "/" +
+                                  utils::tag_slug(t) + ".rss";
+
+    dictionary header;
+    header["Title"] = "#" + vrdi::escape_xml(t);
+    header["Text"] = std::to_string(entries.size()) +
+                     " article(s) - <a href='" + feed_link + "'>rss</a>";
+
+    const std::string expanded_header =
+        utils::expand_to_str(header, constant::template_path::header);
+
+    // Listing fragments are shared with the entries' own pages.
+    page_expansion pe;
+    expand_subpages(ctx, tp, pe);
+
+    for(subpage_expansion& s : pe._subpages)
+    {
+        s._expanded_entries.insert(
+            s._expanded_entries.begin(), expanded_header);
+    }
+
+    pe.produce_result(ctx, tp, tp._output_path);
+    write_feeds(ctx, tp);
+}
+
+// Single page listing every tag, linking to their pages.
+void process_tag_overview(const context& ctx, const tag_index& index)
+{
+    std::string list{"<ul>"};
+
+    for(const auto& [t, entries] : index)
+    {
+        list += "<li><a href='/" + constant::folder::name::tags + "/" +
+                utils::tag_slug(t) + ".html'>" + vrdi::escape_xml(t) +
+                "</a> (" + std::to_string(entries.size()) + ")</li>";
+    }
+
+    list += "</ul>";
+
+    dictionary header;
+    header["Title"] = "tags";
+    header["Text"] = std::move(list);
+
+    archetype::page tp;
+    tp._output_path = constant::folder::path::result +
+                      constant::folder::name::tags + ".html";
+
+    page_expansion pe;
+    pe._subpages.emplace_back()._expanded_entries.emplace_back(
+        utils::expand_to_str(header, constant::template_path::header));
+
+    pe.produce_result(ctx, tp, tp._output_path);
+}
+
+// Returns `false` if some tags were left out because their slugs collide.
+[[nodiscard]] bool process_tag_pages(const context& ctx)
+{
+    std::vector<std::string> collisions;
+    const tag_index index = build_tag_index(ctx, &collisions);
+
+    for(const std::string& c : collisions)
+    {
+        ssvu::lo("tags") << "error: " << c << "\n";
+    }
+
+    vrdi::task_group todo{utils::pool()};
+
+    for(const auto& p : index)
+    {
+        todo.run([&ctx, &p] { process_tag_page(ctx, p.first, p.second); });
+    }
+
+    todo.run([&ctx, &index] { process_tag_overview(ctx, index); });
+    todo.wait();
+
+    return collisions.empty();
+}
+
+// Streams `sitemap.xml` with every page, permalink and tag page, and writes
+// `robots.txt` pointing to it. Only reads the context: safe to run alongside
+// page processing.
+void write_sitemap(const context& ctx)
+{
+    const auto to_url = [](const std::string& output_path)
+    { return utils::result_to_website(output_path); };
+
+    vrdi::sitemap_writer sitemap{
+        constant::folder::path::result, constant::url::path::website};
+
+    ctx._page_mapping.for_all(
+        [&](auto, const archetype::page& ap)
+        {
+            if(ap._entries.empty())
+            {
+                return;
+            }
+
+            std::time_t lastmod =
+                vrdi::last_write_unix_time(ap._path.getStr());
+
+            for(const auto& [order, eid] : ap._entries)
+            {
+                const archetype::entry& ae = ctx._entry_mapping.get(eid);
+                lastmod = std::max(lastmod, ae._source_mtime);
+
+                if(ae._link_name)
+                {
+                    sitemap.add(
+                        to_url(ae._output_path.getStr()), ae._source_mtime);
+                }
+            }
+
+            sitemap.add(to_url(ap._output_path.getStr()), lastmod);
+        });
+
+    for(const auto& [t, entries] : build_tag_index(ctx))
+    {
+        std::time_t lastmod = 0;
+        for(const auto& [order, eid] : entries)
+        {
+            lastmod =
+                std::max(lastmod, ctx._entry_mapping.get(eid)._source_mtime);
+        }
+
+        sitemap.add(to_url(constant::folder::path::tags + utils::tag_slug(t) +
+                           ".html"),
+            lastmod);
+    }
+
+    for(const std::filesystem::path& p : sitemap.finish())
+    {
+        utils::output().note_changed(p);
+    }
+
+    utils::write_to_file(constant::folder::path::result + "robots.txt",
+        "User-agent: *\nAllow: /\n\nSitemap: " + constant::url::path::website +
+            "sitemap.xml\n");
+}
+
+void process_pages(const context& ctx)
+{
+    // Collect the pages first, so that each one becomes an independent task.
+    std::vector<const archetype::page*> pages;
+
+    ctx._page_mapping.for_all(
+        [&pages](auto, const archetype::page& ap) { pages.emplace_back(&ap); });
+
+    vrdi::task_group todo{utils::pool()};
+
+    for(const archetype::page* ap : pages)
+    {
+        todo.run([&ctx, ap] { process_page(ctx, *ap); });
+    }
+
+    todo.wait();
+}
+
+// Indexes every entry with a permalink into `search.idx`, which is queried
+// client-side by `resources/js/search.js`.
+void write_search_index(const context& ctx)
+{
+    vrdi::search_index index{utils::pool()};
+
+    ctx._page_mapping.for_all(
+        [&](auto, const archetype::page& ap)
+        {
+            for(const auto& [order, eid] : ap._entries)
+            {
+                const archetype::entry& ae = ctx._entry_mapping.get(eid);
+                const dictionary& aee = *ae._expand;
+
+                if(!ae._link_name || !aee.has("Title"))
+                {
+                    continue;
+                }
+
+                std::string tags;
+                for(const std::string& t : ae._tags)
+                {
+                    tags += t + " ";
+                }
+
+                const std::string* text = aee.find_value("Text");
+
+                index.add(ssvu::getReplaced(ae._output_path,
+                              constant::folder::path::result, "/"),
+                    aee.at("Title"),
+                    {std::move(tags), text != nullptr ? *text : ""});
+            }
+        });
+
+    utils::write_to_file(
+        constant::folder::path::result + "search.idx", index.encode());
+}
+
+// Parses a decimal number between 1 and `max`.
+[[nodiscard]] std::optional<std::size_t> parse_positive(
+    std::string_view x, std::size_t max)
+{
+    std::size_t result{0};
+    const char* end = x.data() + x.size();
+
+    const auto [ptr, ec] = std::from_chars(x.data(), end, result);
+
+    if(ec != std::errc{} || ptr != end || result == 0 || result > max)
+    {
+        return std::nullopt;
+    }
+
+    return result;
+}
+
+[[nodiscard]] bool parse_settings(int argc, char** argv)
+{
+    for(int i = 1; i < argc; ++i)
+    {
+        const std::string arg{argv[i]};
+
+        if(arg == "--pandoc")
+        {
+            settings::md_backend = settings::markdown_backend::pandoc;
+        }
+        else if(arg == "--no-cache")
+        {
+            settings::use_cache = false;
+        }
+        else if(arg == "--clean")
+        {
+            settings::clean = true;
+        }
+        else if(arg == "--watch")
+        {
+            settings::watch = true;
+        }
+        else if(arg == "--no-precompress")
+        {
+            settings::precompress = false;
+        }
+        else if(arg == "--profile")
+        {
+            settings::profile = true;
+        }
+        else if(arg == "--force-write")
+        {
+            settings::skip_unchanged = false;
+        }
+        else if(arg == "--list-changed")
+        {
+            settings::list_changed = true;
+        }
+        else if(arg == "--serve")
+        {
+            settings::serve_port = 8080;
+
+            const bool has_port = i + 1 < argc && argv[i + 1][0] != '\0' &&
+                                  std::string{argv[i + 1]}.find_first_not_of(
+                                      "0123456789") == std::string::npos;
+
+            if(has_port)
+            {
+                const std::optional<std::size_t> port = parse_positive(
+                    argv[++i], std::numeric_limits<std::uint16_t>::max());
+
+                if(!port)
+                {
+                    ssvu::lo("main") << "invalid port '" << argv[i] << "'\n";
+                    return false;
+                }
+
+                settings::serve_port = static_cast<std::uint16_t>(*port);
+            }
+        }
+        else if((arg == "--jobs" || arg == "-j") && i + 1 < argc)
+        {
+            const std::optional<std::size_t> jobs =
+                parse_positive(argv[++i], constant::pool::max_jobs);
+
+            if(!jobs)
+            {
+                ssvu::lo("main") << "invalid job count '" << argv[i] << "'\n";
+                return false;
+            }
+
+            settings::jobs = *jobs;
+        }
+        else
+        {
+            ssvu::lo("main") << "unknown option '" << arg << "'\n";
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Logs and times one stage of the build.
+template <typename TF>
+void run_phase(std::string_view name, TF&& f)
+{
+    lo_verbose("main") << name << "\n";
+
+    const auto scope = utils::profile("phase", name);
+    f();
+}
+
+// Writes the timeline of the last build and logs its slowest scopes.
+void report_profile()
+{
+    vrdi::profiler& p = utils::profiler();
+
+    if(!p.enabled())
+    {
+        return;
+    }
+
+    if(p.write_chrome_trace(constant::profile::trace_path))
+    {
+        ssvu::lo("profile") << "trace written to '"
+                            << constant::profile::trace_path << "'\n";
+    }
+    else
+    {
+        ssvu::lo("profile") << "could not write '"
+                            << constant::profile::trace_path << "'\n";
+    }
+
+    ssvu::lo("profile") << "slowest scopes (total, count, max):\n";
+
+    for(const auto& r : p.slowest(constant::profile::summary_rows, "phase"))
+    {
+        char buf[64];
+        std::snprintf(buf, sizeof(buf), "%9.2fms %5zux %9.2fms  %-8.*s  ",
+            r._total_us / 1000.0, r._count, r._max_us / 1000.0,
+            static_cast<int>(r._category.size()), r._category.data());
+
+        ssvu::lo("profile") << buf << r._name << "\n";
+    }
+
+    p.clear();
+}
+
+[[nodiscard]] std::unique_ptr<context> load_context()
+{
+    auto ctx = std::make_unique<context>();
+    ctx->_shared_source_hash = utils::shared_source_hash();
+
+    run_phase("loading main menu data", [&] { load_main_menu_data(*ctx); });
+
+    run_phase(
+        "expanding shared page chrome", [&] { expand_shared_chrome(*ctx); });
+
+    run_phase("loading page data", [&] { load_page_data(*ctx); });
+    run_phase("hashing page sources", [&] { hash_page_sources(*ctx); });
+
+    run_phase("sorting page entries",
+        [&]
+        {
+            ctx->_page_mapping.for_all([&ctx](auto, archetype::page& ap)
+                { sort_page_entries(*ctx, ap); });
+        });
+
+    return ctx;
+}
+
+// Returns `false` if some outputs could not be written, or some tags got no
+// page.
+bool generate_outputs(context& ctx)
+{
+    // The sitemap only depends on the loaded context.
+    vrdi::task_group sitemap{utils::pool()};
+    sitemap.run(
+        [&ctx]
+        {
+            const auto scope = utils::profile("phase", "writing sitemap");
+            write_sitemap(ctx);
+        });
+
+    run_phase("processing pages", [&] { process_pages(ctx); });
+    bool tags_processed = true;
+    run_phase("processing tag pages",
+        [&] { tags_processed = process_tag_pages(ctx); });
+    run_phase("building search index", [&] { write_search_index(ctx); });
+
+    sitemap.wait();
+
+    run_phase("flushing outputs",
+        []
+        {
+            utils::output().flush();
+            utils::output().save_index();
+        });
+
+    const bool written = report_failed_outputs();
+
+    if(settings::precompress)
+    {
+        run_phase("precompressing outputs",
+            []
+            {
+                // `resources` is a symlink to the source tree's resources,
+                // which get their sidecars in place.
+                const std::size_t n = utils::sidecars().compress_trees(
+                    {constant::folder::path::result,
+                        constant::folder::path::result +
+                            constant::folder::name::resources},
+                    [](const std::filesystem::path& p)
+                    { utils::output().note_changed(p); });
+
+                utils::sidecars().save_index();
+                ssvu::lo("main") << n << " output(s) precompressed\n";
+            });
+    }
+
+    report_changed_outputs();
+
+    // Pages with failed writes must not look fresh to the next build.
+    if(written)
+    {
+        run_phase("saving build cache manifest",
+            []
+            {
+                utils::cache().save_manifest();
+                utils::cache().commit();
+            });
+    }
+
+    report_profile();
+    return written && tags_processed;
+}
+
+void reload_page(context& ctx, page_id pid, archetype::page& ap)
+{
+    {
+        std::scoped_lock lock(*ap._mtx);
+
+        // Stale entries and asides stay in their mappings, unreferenced.
+        ap._entries.clear();
+        ap._asides.clear();
+        ap._templates.clear();
+
+        using asides_cache = archetype::page::asides_cache;
+        ap._expanded_asides = std::make_shared<asides_cache>();
+    }
+
+    process_page_entries(ctx, ap._output_path, ap._path, pid, ap);
+    process_page_asides(ctx, ap._output_path, ap._path, pid, ap);
+    sort_page_entries(ctx, ap);
+}
+
+// Updates the resident context after the given source files changed. Every
+// `.md`/`.json` file belongs to the page whose folder contains it: only
+// those pages are reloaded. Template changes invalidate compiled templates
+// and change the source hashes of the pages using them. Structural changes
+// (e.g. added or removed pages) fall back to reloading everything.
+void apply_source_changes(
+    std::unique_ptr<context>& ctx, const std::vector<std::string>& changed)
+{
+    namespace fs = std::filesystem;
+
+    const std::string templates_folder =
+        fs::path{constant::folder::path::templates}.lexically_normal().string();
+
+    const std::string main_menu_json =
+        fs::path{constant::folder::path::content +
+                 constant::file::main_menu_json}
+            .lexically_normal()
+            .string();
+
+    // Folder of each page, to find the owner of changed files.
+    std::vector<std::tuple<std::string, page_id, archetype::page*>> pages;
+    ctx->_page_mapping.for_all(
+        [&pages](page_id pid, archetype::page& ap)
+        {
+            pages.emplace_back(fs::path{ap._path.getStr()}
+                                   .parent_path()
+                                   .lexically_normal()
+                                   .string(),
+                pid, &ap);
+        });
+
+    bool templates_changed = false;
+    bool shared_changed = false;
+    bool full_reload = false;
+    std::map<page_id, archetype::page*> affected;
+
+    for(const std::string& c : changed)
+    {
+        const std::string p = fs::path{c}.lexically_normal().string();
+        lo_verbose("watch") << "changed '" << p << "'\n";
+
+        if(ssvu::beginsWith(p, templates_folder))
+        {
+            templates_changed = true;
+            shared_changed |=
+                std::any_of(constant::template_path::shared.begin(),
+                    constant::template_path::shared.end(),
+                    [&p](const std::string& t)
+                    { return fs::path{t}.lexically_normal().string() == p; });
+
+            continue;
+        }
+
+        if(p == main_menu_json)
+        {
+            shared_changed = true;
+            continue;
+        }
+
+        if(ssvu::endsWith(p, constant::file::page_json))
+        {
+            full_reload = true;
+            continue;
+        }
+
+        // Find the innermost page folder containing the file.
+        const std::tuple<std::string, page_id, archetype::page*>* owner{};
+        for(const auto& t : pages)
+        {
+            const std::string& folder = std::get<0>(t);
+
+            if(ssvu::beginsWith(p, folder + "/") &&
+                (owner == nullptr ||
+                    folder.size() > std::get<0>(*owner).size()))
+            {
+                owner = &t;
+            }
+        }
+
+        if(owner == nullptr)
+        {
+            full_reload = true;
+            continue;
+        }
+
+        affected.emplace(std::get<1>(*owner), std::get<2>(*owner));
+    }
+
+    // Reloaded pages leave their old entries and asides behind. Once those
+    // outnumber the live ones, reload everything into a fresh context, which
+    // frees them.
+    const sz_t live = ctx->_entry_mapping.size() +
+                      ctx->_aside_mapping.size() - ctx->_stale_archetypes;
+
+    sz_t stale = ctx->_stale_archetypes;
+    for(const auto& [pid, ap] : affected)
+    {
+        stale += ap->_entries.size() + ap->_asides.size();
+    }
+
+    if(!full_reload && stale > live)
+    {
+        lo_verbose("watch") << "compacting " << stale << " stale elements\n";
+        full_reload = true;
+    }
+
+    if(templates_changed || full_reload)
+    {
+        utils::templates().clear();
+    }
+
+    if(templates_changed)
+    {
+        // Entry and aside fragments were expanded from the old templates.
+        using render_cache = archetype::entry::render_cache;
+
+        ctx->_entry_mapping.for_all([](auto, archetype::entry& ae)
+            { ae._rendered = std::make_shared<render_cache>(); });
+
+        using asides_cache = archetype::page::asides_cache;
+
+        ctx->_page_mapping.for_all([](auto, archetype::page& ap)
+            { ap._expanded_asides = std::make_shared<asides_cache>(); });
+    }
+
+    if(full_reload)
+    {
+        ssvu::lo("watch") << "reloading everything\n";
+        ctx = load_context();
+        return;
+    }
+
+    ctx->_stale_archetypes = stale;
+
+    if(shared_changed)
+    {
+        ctx->_shared_source_hash = utils::shared_source_hash();
+        expand_shared_chrome(*ctx);
+    }
+
+    {
+        vrdi::task_group todo{utils::pool()};
+
+        for(auto [pid, ap] : affected)
+        {
+            ssvu::lo("watch") << "reloading page '" << ap->_full_name
+                              << "'\n";
+
+            todo.run(
+                [&ctx, pid = pid, ap = ap]
+                {
+                    reload_page(*ctx, pid, *ap);
+                    hash_page_source(*ctx, *ap);
+                });
+        }
+
+        todo.wait();
+    }
+
+    // Every page depends on the shared inputs, and may use a changed
+    // template. Otherwise, unaffected pages keep their hash and are skipped
+    // by `process_pages`.
+    if(shared_changed || templates_changed)
+    {
+        hash_page_sources(*ctx);
+    }
+}
+
+void watch(std::unique_ptr<context>& ctx)
+{
+    vrdi::file_watcher watcher;
+
+    if(!watcher.supported())
+    {
+        ssvu::lo("watch") << "watch mode is not supported on this platform\n";
+        return;
+    }
+
+    watcher.add_recursive(constant::folder::path::content);
+    watcher.add_recursive(constant::folder::path::templates);
+
+    while(true)
+    {
+        ssvu::lo("watch") << "waiting for changes...\n";
+
+        const std::vector<std::string> changed =
+            watcher.wait_for_changes(std::chrono::milliseconds{50});
+
+        const auto start = std::chrono::steady_clock::now();
+
+        apply_source_changes(ctx, changed);
+        generate_outputs(*ctx);
+
+        const auto elapsed =
+            std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - start);
+
+        ssvu::lo("watch") << "rebuilt in " << elapsed.count() << "ms\n";
+    }
+}
+
+void serve(std::unique_ptr<context>& ctx)
+{
+    // Workers spend their time in `epoll_wait` and `sendfile`: a handful is
+    // plenty for local previews.
+    vrdi::http_server server{
+        constant::folder::path::result, *settings::serve_port, 4};
+
+    const auto run_server = [&server]
+    {
+        if(!server.run())
+        {
+            ssvu::lo("serve") << "could not start the server\n";
+        }
+    };
+
+    ssvu::lo("serve") << "serving '" << constant::folder::path::result
+                      << "' on http://localhost:" << *settings::serve_port
+                      << "\n";
+
+    if(!settings::watch)
+    {
+        run_server();
+        return;
+    }
+
+    // Outputs are replaced atomically, so serving while rebuilding is safe.
+    std::thread server_thread{run_server};
+    watch(ctx);
+    server_thread.join();
+}
+
+int main(int argc, char** argv)
+{
+    if(!parse_settings(argc, argv))
+    {
+        ssvu::lo("main") << "usage: " << argv[0]
+                         << " [--pandoc] [--no-cache] [--clean] "
+                            "[--force-write] [--no-precompress] [--jobs N] "
+                            "[--list-changed] [--watch] [--serve [PORT]] "
+                            "[--profile]\n";
+        return 1;
+    }
+
+    if(settings::profile)
+    {
+        utils::profiler().enable();
+        utils::profiler().name_current_thread("main");
+        utils::output().profile_with(utils::profiler());
+    }
+
+    run_phase("cleaning and re-creating result folder",
+        [] { clean_and_recreate_result_folder(); });
+
+    std::unique_ptr<context> ctx = load_context();
+    const bool written = generate_outputs(*ctx);
+
+    if(settings::serve_port)
+    {
+        serve(ctx);
+    }
+    else if(settings::watch)
+    {
+        watch(ctx);
+    }
 
     lo_verbose("main") << "done\n";
-    return 0;
+    return written ? 0 : 1;
 }
@@ -1,4 +1,5 @@
 <link rel="alternate" type="application/rss+xml" href="https://vittorioromeo.info/index.rss" />
+<link rel="alternate" type="application/atom+xml" href="https://vittorioromeo.info/index.atom" />
 
 <article>
 
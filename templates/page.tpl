@@ -18,9 +18,7 @@
 
         <script src="{{ResourcesPath}}/js/vendor/modernizr-2.6.2-respond-1.1.0.min.js"></script>
 
-        <script type="text/javascript" async
-            src="https://cdnjs.cloudflare.com/ajax/libs/mathjax/2.7.1/MathJax.js?config=TeX-MML-AM_CHTML">
-        </script>
+        {{MathJax}}
 
     </head>
 
@@ -46,6 +44,12 @@
             <div class="main wrapper clearfix">
                 {{Main}}
 
+                    <aside>
+                        <h3 style="text-align: justify">search</h3>
+                        <input type="search" id="searchInput" placeholder="search articles..." style="width: 100%">
+                        <ul id="searchResults"></ul>
+                    </aside>
+
                     <aside>
                         <h3 style="text-align: justify">contact me</h3>
                         <div class="socialIcons">
@@ -126,6 +130,7 @@
         <!-- <script src="//ajax.googleapis.com/ajax/libs/jquery/1.8.3/jquery.min.js"></script> -->
         <script>window.jQuery || document.write('<script src="{{ResourcesPath}}/js/vendor/jquery-1.8.3.min.js"><\/script>')</script>
         <script src="{{ResourcesPath}}/js/jquery.animate-colors-min.js"></script> <script src="{{ResourcesPath}}/js/main.js"></script>
+        <script src="{{ResourcesPath}}/js/search.js" async></script>
         <link rel="stylesheet" href="{{ResourcesPath}}/js/styles/github.css">
 
         <script>
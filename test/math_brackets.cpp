@@ -0,0 +1,91 @@
+// Renders a post with escaped Markdown brackets, e.g. `\[&\]`, and checks
+// that they come out as literal brackets rather than math.
+
+#include <vrdi/mathml.hpp>
+
+#include <mkdio.h>
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <string_view>
+
+namespace
+{
+    // Same flags as `html_from_md_discount` in `src/main.cpp`.
+    constexpr mkd_flag_t flags = MKD_FENCEDCODE | MKD_GITHUBTAGS |
+                                 MKD_EXTRA_FOOTNOTE | MKD_TOC | MKD_IDANCHOR;
+
+    [[nodiscard]] std::string render(const std::string& md)
+    {
+        MMIOT* doc = mkd_string(md.data(), static_cast<int>(md.size()), flags);
+        std::string result;
+
+        if(doc != nullptr && mkd_compile(doc, flags))
+        {
+            char* html;
+            const int size = mkd_document(doc, &html);
+
+            if(size > 0)
+            {
+                result.assign(html, static_cast<std::size_t>(size));
+            }
+        }
+
+        mkd_cleanup(doc);
+        return result;
+    }
+
+    int failures = 0;
+
+    void expect(bool condition, const char* what)
+    {
+        if(!condition)
+        {
+            std::printf("FAILED: %s\n", what);
+            ++failures;
+        }
+    }
+} // namespace
+
+int main(int argc, char** argv)
+{
+    if(argc != 2)
+    {
+        std::printf("usage: %s <7_lambdas_paper.md>\n", argv[0]);
+        return 1;
+    }
+
+    std::ifstream ifs{argv[1]};
+    const std::string md{std::istreambuf_iterator<char>(ifs),
+        std::istreambuf_iterator<char>()};
+
+    expect(md.find("\\[&\\]") != std::string::npos, "post has `\\[&\\]`");
+
+    int conversions = 0;
+    const std::string html = vrdi::convert_math(render(md),
+        [&](const std::string&, bool)
+        {
+            ++conversions;
+            return std::string{"<math></math>"};
+        });
+
+    expect(conversions == 0, "no math in the post");
+    expect(html.find("[...]") != std::string::npos, "`[...]` is literal");
+    expect(html.find("[&amp;]") != std::string::npos, "`[&]` is literal");
+    expect(html.find("[=]") != std::string::npos, "`[=]` is literal");
+    expect(html.find("[]") != std::string::npos, "`[]` is literal");
+    expect(!vrdi::has_unconverted_math(html), "no MathJax fallback");
+
+    // An escaped backslash leaves `\[` in the HTML, which is still not math,
+    // while dollar delimiters are.
+    const std::string mixed = vrdi::convert_math(
+        "<p>\\[&amp;\\] and $$x$$</p>", [](const std::string& tex, bool)
+        { return "<math>" + tex + "</math>"; });
+
+    expect(mixed == "<p>\\[&amp;\\] and <math>x</math></p>",
+        "only dollar delimiters are math");
+
+    return failures == 0 ? 0 : 1;
+}
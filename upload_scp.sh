@@ -1,3 +1,8 @@
 #!/bin/bash
 
-scp -r ./result/* root@vittorioromeo.info:/var/www/vittorioromeo.info
+# Unchanged outputs keep their contents and modification times, so rsync only
+# transfers what the last builds actually changed. `-L` uploads the contents
+# of the `resources` symlink, including the `.gz`/`.br`/`.zst` sidecars that
+# the generator writes next to them. Run the generator with `--list-changed`
+# to see which outputs a build changed.
+rsync -rtcL ./result/ root@vittorioromeo.info:/var/www/vittorioromeo.info